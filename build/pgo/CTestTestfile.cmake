@@ -0,0 +1,26 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/build/pgo
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test([=[solve-linear]=] "/root/repo/build/pgo/main.exe" "10.10.1" "-i" "20" "-c" "linear" "--seed" "1" "--format" "json")
+set_tests_properties([=[solve-linear]=] PROPERTIES  PASS_REGULAR_EXPRESSION "\"feasible\": (true|false)" WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;85;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[solve-non-linear]=] "/root/repo/build/pgo/main.exe" "10.10.1" "-i" "20" "-c" "non-linear" "--seed" "1" "--format" "json")
+set_tests_properties([=[solve-non-linear]=] PROPERTIES  PASS_REGULAR_EXPRESSION "\"feasible\": (true|false)" WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;85;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[solve-endurance]=] "/root/repo/build/pgo/main.exe" "10.10.1" "-i" "20" "-c" "endurance" "--seed" "1" "--format" "json")
+set_tests_properties([=[solve-endurance]=] PROPERTIES  PASS_REGULAR_EXPRESSION "\"feasible\": (true|false)" WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;85;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[solve-verbose]=] "/root/repo/build/pgo/main.exe" "6.5.1" "-i" "50" "--progress" "log")
+set_tests_properties([=[solve-verbose]=] PROPERTIES  WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;92;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[batch]=] "/root/repo/build/pgo/main.exe" "--batch" "/root/repo/build/pgo/smoke-manifest.txt" "--threads" "2")
+set_tests_properties([=[batch]=] PROPERTIES  FAIL_REGULAR_EXPRESSION "\"error\"" PASS_REGULAR_EXPRESSION "\"cost\"" WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;98;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[cache-clean]=] "/usr/bin/cmake" "-E" "rm" "-rf" "/root/repo/build/pgo/smoke-cache")
+set_tests_properties([=[cache-clean]=] PROPERTIES  FIXTURES_SETUP "smoke-cache-clean" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;104;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[cache-write]=] "/root/repo/build/pgo/main.exe" "10.10.1" "-i" "5" "--cache" "/root/repo/build/pgo/smoke-cache" "--format" "json")
+set_tests_properties([=[cache-write]=] PROPERTIES  FIXTURES_REQUIRED "smoke-cache-clean" FIXTURES_SETUP "smoke-cache" PASS_REGULAR_EXPRESSION "\"write_cache\"" WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;105;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[cache-read]=] "/root/repo/build/pgo/main.exe" "10.10.1" "-i" "5" "--cache" "/root/repo/build/pgo/smoke-cache" "--format" "json")
+set_tests_properties([=[cache-read]=] PROPERTIES  FIXTURES_REQUIRED "smoke-cache" PASS_REGULAR_EXPRESSION "\"load_cache\"" WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;109;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[invalid-argument]=] "/root/repo/build/pgo/main.exe" "6.5.1" "--no-such-option")
+set_tests_properties([=[invalid-argument]=] PROPERTIES  WILL_FAIL "ON" WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;124;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[benchmark]=] "/root/repo/build/pgo/benchmark.exe" "10.10.1" "--min-time" "0.01")
+set_tests_properties([=[benchmark]=] PROPERTIES  WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;130;add_test;/root/repo/CMakeLists.txt;0;")
@@ -0,0 +1,196 @@
+from __future__ import annotations
+
+import argparse
+import csv
+import json
+import statistics
+import subprocess
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Any, Dict, Final, List, Optional, Sequence, TYPE_CHECKING
+
+
+ROOT: Final[Path] = Path(__file__).parent.parent
+
+
+@dataclass(frozen=True, kw_only=True, slots=True)
+class Run:
+    problem: str
+    config: str
+    seed: int
+    iterations: int
+    elapsed: float
+    search_time: float
+    cost: float
+    feasible: bool
+    checkpoints: Dict[float, Optional[float]]
+
+    @property
+    def iterations_per_second(self) -> float:
+        return self.iterations / self.search_time if self.search_time > 0 else float("inf")
+
+    @staticmethod
+    def from_record(record: Dict[str, Any], checkpoints: Sequence[float]) -> Run:
+        timings = record["timings"]
+        history = record["history"]
+
+        # Best cost reached at each checkpoint, None if the initial solution was not ready yet
+        best: Dict[float, Optional[float]] = {}
+        for checkpoint in checkpoints:
+            costs = [cost for time, cost in history if time <= checkpoint]
+            best[checkpoint] = min(costs) if costs else None
+
+        return Run(
+            problem=record["instance"],
+            config=record["config"],
+            seed=record["seed"],
+            iterations=record["iterations"],
+            elapsed=record["elapsed"],
+            search_time=timings["tabu_search"],
+            cost=record["cost"],
+            feasible=record["feasible"],
+            checkpoints=best,
+        )
+
+
+def checkpoint_column(checkpoint: float) -> str:
+    return f"cost@{checkpoint:g}s"
+
+
+def run_solver(executable: Path, problem: str, seed: int, namespace: Namespace) -> Run:
+    command = [
+        str(executable),
+        problem,
+        "-i", str(namespace.iterations),
+        "-t", str(namespace.tabu_size),
+        "-c", namespace.config,
+        "--seed", str(seed),
+        "--format", "json",
+    ]
+    process = subprocess.run(command, cwd=ROOT, capture_output=True, text=True)
+    if process.returncode != 0:
+        raise RuntimeError(f"{' '.join(command)} exited with code {process.returncode}: {process.stderr.strip()}")
+
+    return Run.from_record(json.loads(process.stdout), namespace.checkpoints)
+
+
+def write_csv(path: Path, runs: Sequence[Run], checkpoints: Sequence[float]) -> None:
+    path.parent.mkdir(parents=True, exist_ok=True)
+    with open(path, "w", newline="") as file:
+        writer = csv.writer(file)
+        writer.writerow(["problem", "config", "seed", "iterations", "elapsed", "search_time", "iterations_per_second", "cost", "feasible", *map(checkpoint_column, checkpoints)])
+        for run in runs:
+            writer.writerow([
+                run.problem,
+                run.config,
+                run.seed,
+                run.iterations,
+                f"{run.elapsed:.6f}",
+                f"{run.search_time:.6f}",
+                f"{run.iterations_per_second:.3f}",
+                run.cost,
+                int(run.feasible),
+                *("" if run.checkpoints[c] is None else run.checkpoints[c] for c in checkpoints),
+            ])
+
+
+def read_csv(path: Path) -> List[Dict[str, str]]:
+    with open(path, "r", newline="") as file:
+        return list(csv.DictReader(file))
+
+
+def mean(values: Sequence[float]) -> Optional[float]:
+    return statistics.fmean(values) if values else None
+
+
+def summarize(rows: Sequence[Dict[str, str]], checkpoints: Sequence[float]) -> Dict[str, Dict[str, Optional[float]]]:
+    """Mean and spread of each metric per problem, from CSV rows"""
+    grouped: Dict[str, List[Dict[str, str]]] = {}
+    for row in rows:
+        grouped.setdefault(row["problem"], []).append(row)
+
+    result: Dict[str, Dict[str, Optional[float]]] = {}
+    for problem, group in grouped.items():
+        costs = [float(row["cost"]) for row in group]
+        summary: Dict[str, Optional[float]] = {
+            "cost": mean(costs),
+            "cost_stdev": statistics.stdev(costs) if len(costs) > 1 else 0.0,
+            "iterations_per_second": mean([float(row["iterations_per_second"]) for row in group]),
+        }
+        for checkpoint in checkpoints:
+            column = checkpoint_column(checkpoint)
+            summary[column] = mean([float(row[column]) for row in group if row.get(column)])
+
+        result[problem] = summary
+
+    return result
+
+
+def format_value(value: Optional[float]) -> str:
+    return "-" if value is None else f"{value:.2f}"
+
+
+def format_change(value: Optional[float], baseline: Optional[float]) -> str:
+    if value is None or baseline is None or baseline == 0:
+        return ""
+
+    return f" ({100 * (value - baseline) / baseline:+.2f}%)"
+
+
+def print_summary(
+    current: Dict[str, Dict[str, Optional[float]]],
+    baseline: Optional[Dict[str, Dict[str, Optional[float]]]],
+    checkpoints: Sequence[float],
+) -> None:
+    columns = ["cost", "cost_stdev", "iterations_per_second", *map(checkpoint_column, checkpoints)]
+    for problem, summary in current.items():
+        print(f"{problem}:")
+        reference = baseline.get(problem) if baseline is not None else None
+        for column in columns:
+            change = format_change(summary[column], reference.get(column)) if reference is not None and column != "cost_stdev" else ""
+            print(f"    {column:<24}{format_value(summary[column])}{change}")
+
+
+class Namespace(argparse.Namespace):
+    if TYPE_CHECKING:
+        problems: List[str]
+        seeds: int
+        iterations: int
+        tabu_size: int
+        config: str
+        checkpoints: List[float]
+        executable: Path
+        output: Path
+        baseline: Optional[Path]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Run the solver over several instances and seeds, recording the best cost at fixed time checkpoints",
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter,
+    )
+    parser.add_argument("problems", nargs="+", type=str, help="the problem names in the archive")
+    parser.add_argument("-s", "--seeds", default=3, type=int, help="the number of seeds (0, 1, ...) to run each problem with")
+    parser.add_argument("-i", "--iterations", default=100, type=int, help="the number of iterations to run the algorithm for")
+    parser.add_argument("-t", "--tabu-size", default=10, type=int, help="the tabu size for each neighborhood")
+    parser.add_argument("-c", "--config", default="linear", choices=["linear", "non-linear", "endurance"], help="the energy consumption model to use")
+    parser.add_argument("--checkpoints", default=[0.1, 1.0, 10.0], type=float, nargs="+", help="the times (in seconds) at which to report the best cost")
+    parser.add_argument("--executable", default=ROOT / "build" / "main.exe", type=Path, help="the solver executable")
+    parser.add_argument("-o", "--output", default=ROOT / "result" / "benchmark.csv", type=Path, help="the CSV file to write the runs to")
+    parser.add_argument("-b", "--baseline", default=None, type=Path, help="a CSV file from a previous run to compare against")
+
+    namespace = Namespace()
+    parser.parse_args(namespace=namespace)
+
+    runs: List[Run] = []
+    for problem in namespace.problems:
+        for seed in range(namespace.seeds):
+            run = run_solver(namespace.executable, problem, seed, namespace)
+            print(f"{problem} seed={seed}: cost={run.cost:.2f} iterations/s={run.iterations_per_second:.1f}", file=sys.stderr)
+            runs.append(run)
+
+    write_csv(namespace.output, runs, namespace.checkpoints)
+
+    baseline = summarize(read_csv(namespace.baseline), namespace.checkpoints) if namespace.baseline is not None else None
+    print_summary(summarize(read_csv(namespace.output), namespace.checkpoints), baseline, namespace.checkpoints)
@@ -6,7 +6,7 @@ ROOT_DIR=$(realpath $SCRIPT_DIR/..)
 
 echo "Got root of directory: $ROOT_DIR"
 
-params="-Wall -I src/include -std=c++20"
+params="-Wall -I src/include -std=c++20 -pthread"
 if [ "$1" == "debug" ]
 then
     params="$params -g -D DEBUG"
@@ -15,7 +15,16 @@ else
     params="$params -O3"
 fi
 
+if [[ " $* " == *" telemetry "* ]]
+then
+    params="$params -D TELEMETRY"
+    echo "Building with search telemetry"
+fi
+
 mkdir -p build result
-echo "Compiling $ROOT_DIR/src/main.cpp to $ROOT_DIR/build/main.exe"
-echo "Running \"g++ $params $ROOT_DIR/src/main.cpp -o $ROOT_DIR/build/main.exe\""
-g++ $params $ROOT_DIR/src/main.cpp -o $ROOT_DIR/build/main.exe
+for target in main benchmark
+do
+    echo "Compiling $ROOT_DIR/src/$target.cpp to $ROOT_DIR/build/$target.exe"
+    echo "Running \"g++ $params $ROOT_DIR/src/$target.cpp -o $ROOT_DIR/build/$target.exe\""
+    g++ $params $ROOT_DIR/src/$target.cpp -o $ROOT_DIR/build/$target.exe || exit 1
+done
@@ -0,0 +1,345 @@
+#include <loader.hpp>
+#include <solutions.hpp>
+
+/** @brief Prevent the compiler from optimizing away the computation of `value`. */
+template <typename T>
+void keep(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+ * @brief Runs a function repeatedly until a minimum wall-clock time has elapsed and reports the
+ * average time per call.
+ */
+class Benchmark
+{
+private:
+    const std::string _name;
+    const std::function<void()> _function;
+
+public:
+    Benchmark(const std::string &name, const std::function<void()> &function) : _name(name), _function(function) {}
+
+    const std::string &name() const
+    {
+        return _name;
+    }
+
+    void run(const double &min_time) const
+    {
+        using clock = std::chrono::steady_clock;
+
+        _function(); // Warm up
+
+        std::size_t iterations = 1, total_iterations = 0;
+        double elapsed = 0;
+        while (elapsed < min_time)
+        {
+            auto start = clock::now();
+            for (std::size_t i = 0; i < iterations; i++)
+            {
+                _function();
+            }
+
+            elapsed += std::chrono::duration<double>(clock::now() - start).count();
+            total_iterations += iterations;
+            iterations *= 2;
+        }
+
+        std::cout << utils::format("%-46s %12lu %14.1lf ns/op", _name.c_str(), total_iterations, 1e9 * elapsed / total_iterations) << std::endl;
+    }
+};
+
+/** @brief The customers of every route of every vehicle. */
+template <typename RT>
+std::vector<std::vector<std::size_t>> routes_of(const std::vector<std::vector<RT>> &vehicle_routes)
+{
+    std::vector<std::vector<std::size_t>> result;
+    for (auto &routes : vehicle_routes)
+    {
+        for (auto &route : routes)
+        {
+            result.push_back(route.customers());
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief `count` routes made by repeatedly shuffling all customers of `routes` and cutting them into routes
+ * of the original lengths.
+ *
+ * Almost all of them are distinct, so constructing them in turn mostly misses the route caches of the
+ * problem, as long as `count` is well above the cache capacity.
+ */
+std::vector<std::vector<std::size_t>> shuffled_routes(const std::vector<std::vector<std::size_t>> &routes, const std::size_t &count)
+{
+    std::vector<std::size_t> customers;
+    for (auto &route : routes)
+    {
+        customers.insert(customers.end(), route.begin() + 1, route.end() - 1);
+    }
+
+    std::vector<std::vector<std::size_t>> result;
+    while (result.size() < count && !routes.empty())
+    {
+        std::shuffle(customers.begin(), customers.end(), utils::rng);
+
+        auto iter = customers.begin();
+        for (auto &route : routes)
+        {
+            auto &shuffled = result.emplace_back(1, 0);
+            shuffled.insert(shuffled.end(), iter, iter + (route.size() - 2));
+            shuffled.push_back(0);
+            iter += route.size() - 2;
+        }
+    }
+
+    result.resize(std::min(result.size(), count));
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::string instance = "50.10.1", filter, root = "problems";
+    double min_time = 0.5;
+    try
+    {
+        for (std::size_t i = 0; i < args.size(); i++)
+        {
+            if ((args[i] == "--filter" || args[i] == "--min-time" || args[i] == "--root") && i + 1 >= args.size())
+            {
+                throw std::invalid_argument(utils::format("Missing value for argument %s", args[i].c_str()));
+            }
+
+            if (args[i] == "--filter")
+            {
+                filter = args[++i];
+            }
+            else if (args[i] == "--min-time")
+            {
+                min_time = d2d::_parse_number<double>(args[++i]);
+            }
+            else if (args[i] == "--root")
+            {
+                root = args[++i];
+            }
+            else if (args[i] == "-h" || args[i] == "--help")
+            {
+                std::cout << "Usage: benchmark.exe [instance] [--filter TEXT] [--min-time SECONDS] [--root DIRECTORY]\n";
+                return 0;
+            }
+            else
+            {
+                instance = args[i];
+            }
+        }
+
+        std::map<std::string, std::unique_ptr<d2d::Problem>> problems;
+        for (auto &config : {"linear", "non-linear", "endurance"})
+        {
+            d2d::ProblemOptions options;
+            options.problem = instance;
+            options.config = config;
+            options.root = root;
+            problems[config] = d2d::load_problem(options);
+        }
+
+        auto problem = problems["linear"].get();
+        auto solution = d2d::Solution::initial(problem);
+        auto truck_routes = routes_of(solution->truck_routes);
+
+        // Routes constructed over and over are served by the route caches of the problem
+        const std::size_t unique_routes_count = 1 << 16;
+        auto unique_truck_routes = shuffled_routes(truck_routes, unique_routes_count);
+
+        std::vector<Benchmark> benchmarks;
+        benchmarks.emplace_back(
+            "TruckRoute(customers) [repeated]",
+            [&]()
+            {
+                for (auto &customers : truck_routes)
+                {
+                    keep(d2d::TruckRoute(problem, customers));
+                }
+            });
+        benchmarks.emplace_back(
+            "TruckRoute(customers) [unique]",
+            [&, next = std::size_t(0)]() mutable
+            {
+                for (std::size_t i = 0; i < truck_routes.size(); i++)
+                {
+                    keep(d2d::TruckRoute(problem, unique_truck_routes[next]));
+                    next = (next + 1) % unique_truck_routes.size();
+                }
+            });
+        benchmarks.emplace_back(
+            "TruckRoute::push_back",
+            [&]()
+            {
+                for (auto &customers : truck_routes)
+                {
+                    d2d::TruckRoute route(problem, {0, customers[1], 0}); // Empty routes are not allowed
+                    for (std::size_t i = 2; i + 1 < customers.size(); i++)
+                    {
+                        route.push_back(customers[i]);
+                    }
+
+                    keep(route);
+                }
+            });
+
+        std::vector<d2d::TruckRoute> routes;
+        for (auto &customers : truck_routes)
+        {
+            routes.emplace_back(problem, customers);
+        }
+
+        benchmarks.emplace_back(
+            "TruckRoute::probe_push_back",
+            [&]()
+            {
+                for (auto &route : routes)
+                {
+                    for (std::size_t customer = 1; customer < problem->customers.size(); customer += 7)
+                    {
+                        keep(route.probe_push_back(customer));
+                    }
+                }
+            });
+
+        std::vector<d2d::TruckRoute> reversible;
+        for (auto &customers : truck_routes)
+        {
+            if (customers.size() >= 4)
+            {
+                reversible.emplace_back(problem, customers);
+            }
+        }
+
+        benchmarks.emplace_back(
+            "TruckRoute::reverse",
+            [&]()
+            {
+                for (auto &route : reversible)
+                {
+                    route.reverse(1, route.customers().size() - 2);
+                    keep(route);
+                }
+            });
+
+        for (auto &[config, p] : problems)
+        {
+            auto drone_problem = p.get();
+            auto drone_routes = routes_of(d2d::Solution::initial(drone_problem)->drone_routes);
+            benchmarks.emplace_back(
+                utils::format("DroneRoute(customers) [%s, repeated]", config.c_str()),
+                [drone_problem, drone_routes]()
+                {
+                    for (auto &customers : drone_routes)
+                    {
+                        keep(d2d::DroneRoute(drone_problem, customers));
+                    }
+                });
+
+            auto unique_drone_routes = shuffled_routes(drone_routes, unique_routes_count);
+            benchmarks.emplace_back(
+                utils::format("DroneRoute(customers) [%s, unique]", config.c_str()),
+                [drone_problem, count = drone_routes.size(), unique_drone_routes, next = std::size_t(0)]() mutable
+                {
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        keep(d2d::DroneRoute(drone_problem, unique_drone_routes[next]));
+                        next = (next + 1) % unique_drone_routes.size();
+                    }
+                });
+        }
+
+        std::vector<double> segments;
+        for (auto &routes : solution->truck_routes)
+        {
+            for (auto &route : routes)
+            {
+                segments.insert(segments.end(), route.time_segments().begin(), route.time_segments().end());
+            }
+        }
+
+        utils::FenwickTree<double> tree(segments.begin(), segments.end());
+        benchmarks.emplace_back(
+            utils::format("FenwickTree(%lu elements)", segments.size()),
+            [&segments]()
+            {
+                keep(utils::FenwickTree<double>(segments.begin(), segments.end()));
+            });
+        benchmarks.emplace_back(
+            "FenwickTree::sum(offset, length)",
+            [&tree]()
+            {
+                double result = 0;
+                for (std::size_t i = 0; i < tree.size(); i++)
+                {
+                    result += tree.sum(i, tree.size() - i);
+                }
+
+                keep(result);
+            });
+        benchmarks.emplace_back(
+            "FenwickTree::set",
+            [&tree]()
+            {
+                for (std::size_t i = 0; i < tree.size(); i++)
+                {
+                    tree.set(i, tree.get(i));
+                }
+
+                keep(tree);
+            });
+        benchmarks.emplace_back(
+            "FenwickTree::push_back + pop_back",
+            [&tree]()
+            {
+                for (std::size_t i = 0; i < 16; i++)
+                {
+                    tree.push_back(1.0);
+                }
+
+                for (std::size_t i = 0; i < 16; i++)
+                {
+                    tree.pop_back();
+                }
+
+                keep(tree);
+            });
+        benchmarks.emplace_back(
+            "Solution(truck_routes, drone_routes)",
+            [&]()
+            {
+                keep(d2d::Solution(problem, solution->truck_routes, solution->drone_routes));
+            });
+
+        std::cout << utils::format("Instance %s, %lu truck routes", instance.c_str(), truck_routes.size()) << std::endl;
+        std::cout << utils::format("%-46s %12s %17s", "Benchmark", "Iterations", "Time") << std::endl;
+        for (auto &benchmark : benchmarks)
+        {
+            if (benchmark.name().find(filter) != std::string::npos)
+            {
+                benchmark.run(min_time);
+            }
+        }
+    }
+    catch (std::invalid_argument &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+    catch (std::runtime_error &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "standard.hpp"
+
+namespace utils
+{
+    /**
+     * @brief An allocator returning storage aligned to `Alignment` bytes, so that arrays start on a
+     * cache line and can be read with aligned vector loads.
+     *
+     * @tparam T The element type
+     * @tparam Alignment A power of 2, at least `alignof(T)`
+     */
+    template <typename T, std::size_t Alignment = 64>
+    class AlignedAllocator
+    {
+    public:
+        static_assert(std::has_single_bit(Alignment) && Alignment >= alignof(T), "Invalid alignment");
+
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = AlignedAllocator<U, Alignment>;
+        };
+
+        AlignedAllocator() = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+        T *allocate(const std::size_t &n)
+        {
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+        }
+
+        void deallocate(T *pointer, const std::size_t &)
+        {
+            ::operator delete(pointer, std::align_val_t(Alignment));
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U, Alignment> &) const
+        {
+            return true;
+        }
+    };
+
+    /** @brief A `std::vector` whose storage is aligned to a cache line */
+    template <typename T>
+    using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "loader.hpp"
+#include "report.hpp"
+#include "solutions.hpp"
+
+namespace d2d
+{
+    /** @brief A single problem to solve in batch mode. */
+    class BatchJob
+    {
+    public:
+        /** @brief The name reported in the result record */
+        const std::string name;
+
+        /** @brief The problem instance and configuration to solve */
+        const ProblemOptions options;
+
+        BatchJob(const std::string &name, const ProblemOptions &options) : name(name), options(options) {}
+
+        /**
+         * @brief Read a list of jobs from a manifest file.
+         *
+         * Each non-empty line of the manifest holds the arguments of a single run, in the same form as
+         * the command line (e.g. `50.10.1 -c endurance --speed-type high`), except that verbose mode is
+         * always disabled. Lines starting with `#` are ignored.
+         */
+        static std::vector<BatchJob> read_manifest(const std::string &path);
+    };
+
+    inline std::vector<BatchJob> BatchJob::read_manifest(const std::string &path)
+    {
+        std::ifstream manifest(path);
+        if (!manifest)
+        {
+            throw std::runtime_error(utils::format("Unable to open batch manifest \"%s\"", path.c_str()));
+        }
+
+        std::vector<BatchJob> jobs;
+        std::string line;
+        for (std::size_t line_number = 1; std::getline(manifest, line); line_number++)
+        {
+            std::istringstream stream(line);
+            std::vector<std::string> args;
+            for (std::string arg; stream >> arg;)
+            {
+                args.push_back(arg);
+            }
+
+            if (args.empty() || args.front().front() == '#')
+            {
+                continue;
+            }
+
+            try
+            {
+                auto options = ProblemOptions::parse(args);
+                options.verbose = false; // Progress bars of concurrent jobs would interleave on stderr
+                jobs.emplace_back(options.instance_name(), options);
+            }
+            catch (std::invalid_argument &e)
+            {
+                throw std::invalid_argument(utils::format("%s:%lu: %s", path.c_str(), line_number, e.what()));
+            }
+        }
+
+        return jobs;
+    }
+
+    /**
+     * @brief Solve many problems in a single process on a fixed pool of worker threads.
+     *
+     * Workers repeatedly take the next pending job from a shared queue, so long-running instances
+     * do not hold back the remaining ones. Each finished job produces one JSON record on the output
+     * stream, in completion order. The hardware threads are shared among the workers, which bounds
+     * the parallelism within each job. A job that fails produces an error record instead, and is
+     * counted in the value returned by run().
+     */
+    class BatchRunner
+    {
+    private:
+        const std::vector<BatchJob> _jobs;
+        const std::size_t _threads;
+
+        std::atomic<std::size_t> _next_job;
+        std::atomic<std::size_t> _failures;
+        std::mutex _output_mutex;
+        std::ostream &_output;
+
+        std::string _solve(const BatchJob &job);
+        void _worker(const std::size_t &parallel_threads);
+
+    public:
+        /**
+         * @param jobs The jobs to solve
+         * @param threads The number of worker threads, `0` to use the hardware concurrency
+         * @param output The stream to write result records to
+         */
+        BatchRunner(const std::vector<BatchJob> &jobs, const std::size_t &threads, std::ostream &output)
+            : _jobs(jobs),
+              _threads(std::max<std::size_t>(1, threads == 0 ? std::thread::hardware_concurrency() : threads)),
+              _next_job(0),
+              _failures(0),
+              _output(output) {}
+
+        /**
+         * @brief Solve all jobs, returning once every record has been written.
+         * @return The number of jobs that failed
+         */
+        std::size_t run();
+    };
+
+    inline std::string BatchRunner::_solve(const BatchJob &job)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const auto elapsed = [&start]()
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        utils::BufferedWriter writer;
+        try
+        {
+            if (job.options.seed.has_value())
+            {
+                utils::rng.seed(job.options.seed.value());
+            }
+
+            utils::PhaseTimings timings;
+            std::vector<std::pair<double, double>> history;
+            auto problem = load_problem(job.options, &timings);
+
+            std::unique_ptr<utils::ConvergenceTrace> trace;
+            if (!job.options.trace.empty())
+            {
+                trace = std::make_unique<utils::ConvergenceTrace>(job.options.trace);
+            }
+
+            auto solution = Solution::tabu_search(problem.get(), &timings, &history, trace.get());
+
+            write_solution_record(writer, job.name, job.options, *solution, timings, history, elapsed());
+        }
+        catch (std::exception &e)
+        {
+            _failures++;
+            writer.write("{\"instance\": ").write_string(job.name);
+            writer.write(", \"error\": ").write_string(e.what());
+            writer.write(", \"elapsed\": ").write_number(elapsed()).put('}');
+        }
+
+        return writer.buffer();
+    }
+
+    inline void BatchRunner::_worker(const std::size_t &parallel_threads)
+    {
+        utils::max_parallel_threads = parallel_threads;
+        for (auto index = _next_job++; index < _jobs.size(); index = _next_job++)
+        {
+            auto record = _solve(_jobs[index]);
+
+            std::lock_guard<std::mutex> lock(_output_mutex);
+            _output << record << std::endl;
+        }
+    }
+
+    inline std::size_t BatchRunner::run()
+    {
+        _next_job = 0;
+        _failures = 0;
+
+        auto workers_count = std::min(_threads, _jobs.size());
+        auto parallel_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency() / std::max<std::size_t>(workers_count, 1));
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < workers_count; i++)
+        {
+            workers.emplace_back(&BatchRunner::_worker, this, parallel_threads);
+        }
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        return _failures;
+    }
+}
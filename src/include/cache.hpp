@@ -0,0 +1,224 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "problem.hpp"
+
+namespace d2d
+{
+    /**
+     * @brief A compact binary cache of a problem instance, read through a read-only memory mapping
+     * without any parsing.
+     *
+     * Layout (native byte order, every section 8-byte aligned):
+     * - a 72-byte header: magic, format version, byte order marker, customers count (including
+     *   the depot), trucks count, drones count, payload size, payload checksum and the size and
+     *   modification time of the source instance file
+     * - `x`, `y`, `demand`, `truck_service_time` and `drone_service_time` as `double[n]`
+     * - `dronable` as `uint8_t[n]`, zero-padded to a multiple of 8 bytes
+     * - the distance matrix as `double[n * n]`
+     *
+     * Truck travel times depend on the departure time and drone energy on the carried weight, so
+     * neither can be tabulated per pair of customers; only the distance matrix is precomputed.
+     */
+    class InstanceCache
+    {
+    private:
+        struct _Header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byte_order;
+            std::uint64_t customers_count;
+            std::uint64_t trucks_count;
+            std::uint64_t drones_count;
+            std::uint64_t payload_size;
+            std::uint64_t checksum;
+            std::uint64_t source_size;
+            std::int64_t source_time;
+        };
+
+        static_assert(sizeof(_Header) == 72);
+
+        static constexpr char _magic[8] = {'D', '2', 'D', 'C', 'A', 'C', 'H', 'E'};
+        static constexpr std::uint32_t _version = 1;
+        static constexpr std::uint32_t _byte_order = 0x01020304;
+
+        static std::size_t _dronable_size(const std::size_t &n)
+        {
+            return (n + 7) / 8 * 8;
+        }
+
+        static std::size_t _payload_size(const std::size_t &n)
+        {
+            return 5 * n * sizeof(double) + _dronable_size(n) + n * n * sizeof(double);
+        }
+
+        static std::uint64_t _checksum(const char *data, const std::size_t &size);
+
+        std::shared_ptr<const utils::MappedFile> _file;
+        const _Header *_header;
+
+        const double *_column(const std::size_t &index) const
+        {
+            return reinterpret_cast<const double *>(_file->data() + sizeof(_Header)) + index * _header->customers_count;
+        }
+
+    public:
+        /**
+         * @brief Map and validate a cache file.
+         * @note `std::runtime_error` is thrown if the file is missing, truncated, corrupted or was
+         * written by an incompatible version.
+         */
+        InstanceCache(const std::string &path);
+
+        /** @brief Whether the cache was built from the current version of the instance file `source`. */
+        bool is_fresh(const std::string &source) const;
+
+        std::size_t trucks_count() const
+        {
+            return _header->trucks_count;
+        }
+
+        std::size_t drones_count() const
+        {
+            return _header->drones_count;
+        }
+
+        /** @brief The customers, starting with the depot `0` */
+        std::vector<Customer> customers() const;
+
+        /** @brief The distance matrix, borrowed from the mapping which it keeps alive */
+        utils::SquareMatrix<double> distances() const;
+
+        /**
+         * @brief Write the instance data of `problem`, read from the instance file `source`, to a
+         * cache file.
+         *
+         * The file is written under a temporary name and renamed into place, so concurrent readers
+         * never observe a partially written cache.
+         */
+        static void write(const std::string &path, const std::string &source, const Problem &problem);
+    };
+
+    inline std::uint64_t InstanceCache::_checksum(const char *data, const std::size_t &size)
+    {
+        // FNV-1a over 64-bit words, the payload size is always a multiple of 8
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (std::size_t offset = 0; offset + 8 <= size; offset += 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, data + offset, 8);
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
+    inline InstanceCache::InstanceCache(const std::string &path)
+        : _file(std::make_shared<const utils::MappedFile>(path))
+    {
+        if (_file->size() < sizeof(_Header))
+        {
+            throw std::runtime_error(utils::format("Instance cache \"%s\" is truncated", path.c_str()));
+        }
+
+        _header = reinterpret_cast<const _Header *>(_file->data());
+        if (std::memcmp(_header->magic, _magic, sizeof(_magic)) != 0)
+        {
+            throw std::runtime_error(utils::format("\"%s\" is not an instance cache", path.c_str()));
+        }
+
+        if (_header->version != _version || _header->byte_order != _byte_order)
+        {
+            throw std::runtime_error(utils::format("Instance cache \"%s\" was written by an incompatible version", path.c_str()));
+        }
+
+        if (_header->payload_size != _payload_size(_header->customers_count) ||
+            _file->size() != sizeof(_Header) + _header->payload_size)
+        {
+            throw std::runtime_error(utils::format("Instance cache \"%s\" is truncated", path.c_str()));
+        }
+
+        if (_checksum(_file->data() + sizeof(_Header), _header->payload_size) != _header->checksum)
+        {
+            throw std::runtime_error(utils::format("Instance cache \"%s\" is corrupted", path.c_str()));
+        }
+    }
+
+    inline bool InstanceCache::is_fresh(const std::string &source) const
+    {
+        std::error_code error;
+        auto size = std::filesystem::file_size(source, error);
+        auto time = std::filesystem::last_write_time(source, error);
+        return !error && _header->source_size == size && _header->source_time == time.time_since_epoch().count();
+    }
+
+    inline std::vector<Customer> InstanceCache::customers() const
+    {
+        std::size_t n = _header->customers_count;
+        const double *x = _column(0), *y = _column(1), *demand = _column(2), *truck_service_time = _column(3), *drone_service_time = _column(4);
+        const std::uint8_t *dronable = reinterpret_cast<const std::uint8_t *>(_column(5));
+
+        std::vector<Customer> customers;
+        customers.reserve(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            customers.emplace_back(x[i], y[i], demand[i], dronable[i] != 0, truck_service_time[i], drone_service_time[i]);
+        }
+
+        return customers;
+    }
+
+    inline utils::SquareMatrix<double> InstanceCache::distances() const
+    {
+        std::size_t n = _header->customers_count;
+        auto data = reinterpret_cast<const double *>(reinterpret_cast<const char *>(_column(5)) + _dronable_size(n));
+        return utils::SquareMatrix<double>(n, data, _file);
+    }
+
+    inline void InstanceCache::write(const std::string &path, const std::string &source, const Problem &problem)
+    {
+        std::size_t n = problem.customers.size();
+
+        std::vector<char> payload(_payload_size(n));
+        double *columns = reinterpret_cast<double *>(payload.data());
+        std::uint8_t *dronable = reinterpret_cast<std::uint8_t *>(columns + 5 * n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            auto &customer = problem.customers[i];
+            columns[i] = customer.x;
+            columns[n + i] = customer.y;
+            columns[2 * n + i] = customer.demand;
+            columns[3 * n + i] = customer.truck_service_time;
+            columns[4 * n + i] = customer.drone_service_time;
+            dronable[i] = customer.dronable;
+        }
+
+        std::memcpy(payload.data() + 5 * n * sizeof(double) + _dronable_size(n), problem.distances.data(), n * n * sizeof(double));
+
+        _Header header;
+        std::memcpy(header.magic, _magic, sizeof(_magic));
+        header.version = _version;
+        header.byte_order = _byte_order;
+        header.customers_count = n;
+        header.trucks_count = problem.trucks_count;
+        header.drones_count = problem.drones_count;
+        header.payload_size = payload.size();
+        header.checksum = _checksum(payload.data(), payload.size());
+        header.source_size = std::filesystem::file_size(source);
+        header.source_time = std::filesystem::last_write_time(source).time_since_epoch().count();
+
+        auto temporary = utils::format("%s.%lu.tmp", path.c_str(), std::hash<std::thread::id>()(std::this_thread::get_id()));
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(payload.data(), payload.size());
+            if (!file)
+            {
+                throw std::runtime_error(utils::format("Unable to write instance cache \"%s\"", temporary.c_str()));
+            }
+        }
+
+        std::filesystem::rename(temporary, path);
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "utils.hpp"
+
+namespace utils
+{
+    /** @brief How thoroughly debug builds verify incremental evaluations. */
+    enum class CheckLevel
+    {
+        /** @brief Only cheap structural invariants, checked after every mutation */
+        invariants,
+        /** @brief Invariants, plus a full recomputation after 1 in every `period` mutations */
+        sampled,
+        /** @brief A full recomputation after every mutation */
+        full
+    };
+
+    /**
+     * @brief Run-time configuration of the checks compiled in by `DEBUG`.
+     *
+     * A full recomputation costs as much as building the route or solution from scratch, which
+     * makes long debug runs on large instances impractical. Sampling keeps incremental evaluations
+     * under test at a fraction of that cost.
+     */
+    class DebugChecks
+    {
+    private:
+        std::atomic<CheckLevel> _level;
+        std::atomic<std::size_t> _period;
+
+        /** @brief Number of mutations sampled by the current thread */
+        inline static thread_local std::size_t _counter = 0;
+
+    public:
+        DebugChecks() : _level(CheckLevel::full), _period(1) {}
+
+        /**
+         * @param level The check level
+         * @param period With `CheckLevel::sampled`, fully verify 1 in every `period` mutations
+         */
+        void configure(const CheckLevel &level, const std::size_t &period)
+        {
+            _level.store(level, std::memory_order_relaxed);
+            _period.store(std::max<std::size_t>(period, 1), std::memory_order_relaxed);
+        }
+
+        CheckLevel level() const
+        {
+            return _level.load(std::memory_order_relaxed);
+        }
+
+        /** @brief Whether the current mutation should be verified by a full recomputation. */
+        bool sample() const
+        {
+            switch (level())
+            {
+            case CheckLevel::invariants:
+                return false;
+
+            case CheckLevel::sampled:
+                return ++_counter % _period.load(std::memory_order_relaxed) == 0;
+
+            default:
+                return true;
+            }
+        }
+
+        /**
+         * @brief Parse a level name: "invariants", "sampled" or "full".
+         * @note `std::invalid_argument` is thrown on unknown names.
+         */
+        static CheckLevel parse_level(const std::string &name);
+    };
+
+    inline CheckLevel DebugChecks::parse_level(const std::string &name)
+    {
+        if (name == "invariants")
+        {
+            return CheckLevel::invariants;
+        }
+
+        if (name == "sampled")
+        {
+            return CheckLevel::sampled;
+        }
+
+        if (name == "full")
+        {
+            return CheckLevel::full;
+        }
+
+        throw std::invalid_argument(format("Unknown check level \"%s\"", name.c_str()));
+    }
+
+    /** @brief The checks performed by debug builds, shared by all threads */
+    inline DebugChecks debug_checks;
+}
@@ -28,6 +28,12 @@ namespace d2d
         {
             return _maximum_velocity * _coefficients[index % _coefficients.size()];
         }
+
+        /** @brief The maximum speed over all time periods */
+        double maximum_speed() const
+        {
+            return _maximum_velocity * *std::max_element(_coefficients.begin(), _coefficients.end());
+        }
     };
 
     enum StatsType
@@ -259,7 +259,7 @@ namespace utils
     }
 
     template <>
-    bool approximate(const FenwickTree<double> &first, const FenwickTree<double> &second)
+    inline bool approximate(const FenwickTree<double> &first, const FenwickTree<double> &second)
     {
         return approximate(first.array(), second.array());
     }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "parallel.hpp"
 #include "random.hpp"
 #include "routes.hpp"
 
@@ -7,68 +8,75 @@ namespace d2d
 {
     class Solution; // forward declaration
 
-    bool _truck_try_insert(TruckRoute &route, const std::size_t &customer)
+    /** @brief Append `customer` to `route` if the result satisfies all constraints. */
+    template <typename _RouteT>
+    bool _try_insert(_RouteT &route, const std::size_t &customer)
     {
-        TruckRoute old(route);
-        route.push_back(customer);
-        if (route.waiting_time_violations().sum() > 0 || route.capacity_violation() > 0)
+        auto probe = route.probe_push_back(customer);
+        if (!probe.feasible())
         {
-            route = old;
             return false;
         }
 
-        return true;
-    };
-
-    bool _drone_try_insert(DroneRoute &route, const std::size_t &customer)
-    {
-        DroneRoute old(route);
         route.push_back(customer);
-        if (route.waiting_time_violations().sum() > 0 || route.capacity_violation() > 0 || route.energy_violation() > 0)
+
+#ifdef DEBUG
+        if (utils::debug_checks.sample() &&
+            (!utils::approximate(probe.working_time, route.working_time()) ||
+             !utils::approximate(probe.waiting_time_violation, route.waiting_time_violation())))
         {
-            route = old;
-            return false;
+            throw std::runtime_error("Inconsistent append probe, possibly an error in calculation");
         }
+#endif
 
         return true;
-    };
+    }
 
-#define INITIAL_12_PHASE_3(problem, third_phase, truck_routes, drone_routes)                             \
-    {                                                                                                    \
-        std::size_t truck = 0, drone = 0;                                                                \
-                                                                                                         \
-        std::shuffle(third_phase.begin(), third_phase.end(), utils::rng);                                \
-        while (!third_phase.empty())                                                                     \
-        {                                                                                                \
-            auto customer = third_phase.back();                                                          \
-            third_phase.pop_back();                                                                      \
-                                                                                                         \
-            if (problem->customers[customer].dronable)                                                   \
-            {                                                                                            \
-                if (!_drone_try_insert(drone_routes[drone % problem->drones_count].back(), customer))    \
-                {                                                                                        \
-                    drone_routes[drone % problem->drones_count].push_back(DroneRoute({0, customer, 0})); \
-                }                                                                                        \
-                                                                                                         \
-                drone++;                                                                                 \
-            }                                                                                            \
-            else                                                                                         \
-            {                                                                                            \
-                if (!_truck_try_insert(truck_routes[truck % problem->trucks_count].back(), customer))    \
-                {                                                                                        \
-                    truck_routes[truck % problem->trucks_count].push_back(TruckRoute({0, customer, 0})); \
-                }                                                                                        \
-                                                                                                         \
-                truck++;                                                                                 \
-            }                                                                                            \
-        }                                                                                                \
+    inline bool _truck_try_insert(TruckRoute &route, const std::size_t &customer)
+    {
+        return _try_insert(route, customer);
+    }
+
+    inline bool _drone_try_insert(DroneRoute &route, const std::size_t &customer)
+    {
+        return _try_insert(route, customer);
     }
 
-    std::shared_ptr<Solution> initial_12(const bool &nearest)
+#define INITIAL_12_PHASE_3(problem, third_phase, truck_routes, drone_routes)                                      \
+    {                                                                                                             \
+        std::size_t truck = 0, drone = 0;                                                                         \
+                                                                                                                  \
+        std::shuffle(third_phase.begin(), third_phase.end(), utils::rng);                                         \
+        while (!third_phase.empty())                                                                              \
+        {                                                                                                         \
+            auto customer = third_phase.back();                                                                   \
+            third_phase.pop_back();                                                                               \
+                                                                                                                  \
+            if (problem->customer_arrays.dronable[customer])                                                      \
+            {                                                                                                     \
+                if (!_drone_try_insert(drone_routes[drone % problem->drones_count].back(), customer))             \
+                {                                                                                                 \
+                    drone_routes[drone % problem->drones_count].push_back(DroneRoute(problem, {0, customer, 0})); \
+                }                                                                                                 \
+                                                                                                                  \
+                drone++;                                                                                          \
+            }                                                                                                     \
+            else                                                                                                  \
+            {                                                                                                     \
+                if (!_truck_try_insert(truck_routes[truck % problem->trucks_count].back(), customer))             \
+                {                                                                                                 \
+                    truck_routes[truck % problem->trucks_count].push_back(TruckRoute(problem, {0, customer, 0})); \
+                }                                                                                                 \
+                                                                                                                  \
+                truck++;                                                                                          \
+            }                                                                                                     \
+        }                                                                                                         \
+    }
+
+    inline std::shared_ptr<Solution> initial_12(const Problem *problem, const bool &nearest)
     {
-        auto problem = Problem::get_instance();
         std::vector<std::vector<TruckRoute>> truck_routes(problem->trucks_count);
-        std::vector<std::vector<DroneRoute>> drone_routes(problem->trucks_count);
+        std::vector<std::vector<DroneRoute>> drone_routes(problem->drones_count);
 
         std::vector<std::size_t> second_phase;
         // Begin first phase
@@ -87,14 +95,14 @@ namespace d2d
             auto drone_iter = drone_routes.begin();
             for (auto &customer : first_phase)
             {
-                if (drone_iter != drone_routes.end() && problem->customers[customer].dronable)
+                if (drone_iter != drone_routes.end() && problem->customer_arrays.dronable[customer])
                 {
-                    drone_iter->push_back(DroneRoute({0, customer, 0}));
+                    drone_iter->push_back(DroneRoute(problem, {0, customer, 0}));
                     drone_iter++;
                 }
                 else if (truck_iter != truck_routes.end())
                 {
-                    truck_iter->push_back(TruckRoute({0, customer, 0}));
+                    truck_iter->push_back(TruckRoute(problem, {0, customer, 0}));
                     truck_iter++;
                 }
                 else
@@ -110,7 +118,7 @@ namespace d2d
         {
             for (auto &customer : second_phase)
             {
-                if (problem->customers[customer].dronable)
+                if (problem->customer_arrays.dronable[customer])
                 {
                     bool inserted = false;
                     for (auto &routes : drone_routes)
@@ -166,14 +174,13 @@ namespace d2d
         INITIAL_12_PHASE_3(problem, third_phase, truck_routes, drone_routes);
         // End third phase
 
-        return std::make_shared<Solution>(truck_routes, drone_routes);
+        return std::make_shared<Solution>(problem, truck_routes, drone_routes);
     }
 
-    std::shared_ptr<Solution> initial_3()
+    inline std::shared_ptr<Solution> initial_3(const Problem *problem)
     {
-        auto problem = Problem::get_instance();
         std::vector<std::vector<TruckRoute>> truck_routes(problem->trucks_count);
-        std::vector<std::vector<DroneRoute>> drone_routes(problem->trucks_count);
+        std::vector<std::vector<DroneRoute>> drone_routes(problem->drones_count);
 
         std::vector<std::size_t> customers_by_angle(problem->customers.size() - 1);
         std::iota(customers_by_angle.begin(), customers_by_angle.end(), 1);
@@ -181,8 +188,8 @@ namespace d2d
             customers_by_angle.begin(), customers_by_angle.end(),
             [&problem](const std::size_t &first, const std::size_t &second)
             {
-                return std::atan2(problem->customers[first].y, problem->customers[first].x) <
-                       std::atan2(problem->customers[second].y, problem->customers[second].x);
+                return std::atan2(problem->customer_arrays.y[first], problem->customer_arrays.x[first]) <
+                       std::atan2(problem->customer_arrays.y[second], problem->customer_arrays.x[second]);
             });
 
         std::rotate(
@@ -195,14 +202,14 @@ namespace d2d
         std::vector<std::size_t> next_phase;
         for (auto &customer : customers_by_angle)
         {
-            if (drone_iter != drone_routes.end() && problem->customers[customer].dronable)
+            if (drone_iter != drone_routes.end() && problem->customer_arrays.dronable[customer])
             {
-                drone_iter->push_back(DroneRoute({0, customer, 0}));
+                drone_iter->push_back(DroneRoute(problem, {0, customer, 0}));
                 drone_iter++;
             }
             else if (truck_iter != truck_routes.end())
             {
-                truck_iter->push_back(TruckRoute({0, customer, 0}));
+                truck_iter->push_back(TruckRoute(problem, {0, customer, 0}));
                 truck_iter++;
             }
             else
@@ -213,7 +220,607 @@ namespace d2d
 
         INITIAL_12_PHASE_3(problem, next_phase, truck_routes, drone_routes);
 
-        return std::make_shared<Solution>(truck_routes, drone_routes);
+        return std::make_shared<Solution>(problem, truck_routes, drone_routes);
+    }
+
+    inline bool _feasible(const TruckRoute &route)
+    {
+        return route.capacity_violation() == 0 && route.waiting_time_violation() == 0;
+    }
+
+    inline bool _feasible(const DroneRoute &route)
+    {
+        return route.capacity_violation() == 0 && route.waiting_time_violation() == 0 && route.energy_violation() == 0;
+    }
+
+    /**
+     * @brief Assign routes to vehicles longest first, each to the currently least loaded vehicle of
+     * its type.
+     */
+    inline std::shared_ptr<Solution> _assign_routes(
+        const Problem *problem,
+        std::vector<TruckRoute> &&truck_trips,
+        std::vector<DroneRoute> &&drone_trips)
+    {
+        std::vector<std::vector<TruckRoute>> truck_routes(problem->trucks_count);
+        std::vector<std::vector<DroneRoute>> drone_routes(problem->drones_count);
+
+#define ASSIGN_ROUTES(trips, vehicle_routes)                                             \
+    {                                                                                    \
+        std::sort(                                                                       \
+            trips.begin(), trips.end(),                                                  \
+            [](const auto &first, const auto &second)                                    \
+            {                                                                            \
+                return first.working_time() > second.working_time();                     \
+            });                                                                          \
+                                                                                         \
+        std::vector<double> loads(vehicle_routes.size());                                \
+        for (auto &trip : trips)                                                         \
+        {                                                                                \
+            auto vehicle = std::min_element(loads.begin(), loads.end()) - loads.begin(); \
+            loads[vehicle] += trip.working_time();                                       \
+            vehicle_routes[vehicle].push_back(std::move(trip));                          \
+        }                                                                                \
+    }
+
+        ASSIGN_ROUTES(truck_trips, truck_routes);
+        ASSIGN_ROUTES(drone_trips, drone_routes);
+#undef ASSIGN_ROUTES
+
+        return std::make_shared<Solution>(problem, truck_routes, drone_routes);
+    }
+
+    /** @brief A trip serving a segment of the giant tour in `initial_split` */
+    struct _SplitTrip
+    {
+        /** @brief The segment `[begin, end)` of the giant tour */
+        std::size_t begin, end;
+        bool drone;
+        double working_time;
+    };
+
+    /**
+     * @brief Split a giant tour into trips, then assign the trips to vehicles.
+     *
+     * The giant tour visits all customers by nearest neighbor from the depot. A shortest path over
+     * it (Prins' Split) decides where each trip starts and ends, and whether a truck or a drone
+     * serves it. A trip costs its working time divided by the fleet size of its vehicle type, so
+     * that the total cost estimates the makespan of a balanced assignment. Trips are only extended
+     * while they remain feasible, bounding the DP to `O(nL)` route appends, where `L` is the length
+     * of the longest feasible trip. Trips are then assigned longest first to the least loaded
+     * vehicle of their type.
+     */
+    inline std::shared_ptr<Solution> initial_split(const Problem *problem)
+    {
+        const std::size_t n = problem->customers.size() - 1;
+
+        std::vector<std::size_t> tour;
+        tour.reserve(n);
+        {
+            std::vector<bool> visited(n + 1);
+            std::size_t current = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                std::size_t next = 0;
+                for (std::size_t customer = 1; customer <= n; customer++)
+                {
+                    if (!visited[customer] && (next == 0 || problem->distances[current][customer] < problem->distances[current][next]))
+                    {
+                        next = customer;
+                    }
+                }
+
+                visited[next] = true;
+                tour.push_back(next);
+                current = next;
+            }
+        }
+
+        // costs[j] is the cost of serving tour[0..j), the last trip being labels[j]
+        std::vector<double> costs(n + 1, std::numeric_limits<double>::infinity());
+        std::vector<_SplitTrip> labels(n + 1);
+        costs[0] = 0;
+
+        const auto extend = [&problem, &tour, &n, &costs, &labels](const std::size_t &begin, auto route, const std::size_t &fleet)
+        {
+            constexpr bool drone = std::is_same_v<decltype(route), DroneRoute>;
+            for (std::size_t end = begin + 1;; end++)
+            {
+                double cost = costs[begin] + route.working_time() / fleet;
+                if (cost < costs[end])
+                {
+                    costs[end] = cost;
+                    labels[end] = _SplitTrip{begin, end, drone, route.working_time()};
+                }
+
+                if (end == n || (drone && !problem->customer_arrays.dronable[tour[end]]) || !route.probe_push_back(tour[end]).feasible())
+                {
+                    break;
+                }
+
+                route.push_back(tour[end]);
+            }
+        };
+
+        for (std::size_t begin = 0; begin < n; begin++)
+        {
+            if (std::isinf(costs[begin]))
+            {
+                continue;
+            }
+
+            auto customer = tour[begin];
+            if (problem->drones_count > 0 && problem->customer_arrays.dronable[customer])
+            {
+                DroneRoute route(problem, {0, customer, 0});
+                if (_feasible(route) || problem->trucks_count == 0)
+                {
+                    extend(begin, route, problem->drones_count);
+                }
+            }
+
+            if (problem->trucks_count > 0)
+            {
+                // A truck may serve a single customer even if infeasible, so that a split always exists
+                extend(begin, TruckRoute(problem, {0, customer, 0}), problem->trucks_count);
+            }
+        }
+
+        if (std::isinf(costs[n]))
+        {
+            throw std::runtime_error("Unable to split the giant tour into trips");
+        }
+
+        std::vector<TruckRoute> truck_trips;
+        std::vector<DroneRoute> drone_trips;
+        for (auto end = n; end > 0; end = labels[end].begin)
+        {
+            auto &trip = labels[end];
+            std::vector<std::size_t> customers(tour.begin() + trip.begin, tour.begin() + trip.end);
+            customers.insert(customers.begin(), 0);
+            customers.push_back(0);
+
+            if (trip.drone)
+            {
+                drone_trips.emplace_back(problem, customers);
+            }
+            else
+            {
+                truck_trips.emplace_back(problem, customers);
+            }
+        }
+
+        return _assign_routes(problem, std::move(truck_trips), std::move(drone_trips));
+    }
+
+    /** @brief The saving of serving `first` and `second` consecutively instead of in separate trips */
+    struct _Saving
+    {
+        double value;
+        std::size_t first, second;
+    };
+
+    /**
+     * @brief Clarke-Wright savings construction.
+     *
+     * Dronable customers nearest to the depot are served by drones, as long as the estimated work
+     * per drone stays below the estimated work per truck (both estimated from single-customer
+     * trips). Starting from a trip per customer, trips of the same vehicle type are then merged in
+     * decreasing order of savings `d(0, i) + d(0, j) - d(i, j)` whenever the merged trip remains
+     * feasible. The savings list is computed and sorted in parallel. Finally, trips are assigned
+     * longest first to the least loaded vehicle of their type.
+     */
+    inline std::shared_ptr<Solution> initial_savings(const Problem *problem)
+    {
+        const std::size_t n = problem->customers.size() - 1;
+        const auto &distances = problem->distances;
+
+        std::vector<bool> by_drone(n + 1);
+        if (problem->drones_count > 0)
+        {
+            std::vector<std::size_t> dronable;
+            double truck_work = 0, drone_work = 0;
+            for (std::size_t customer = 1; customer <= n; customer++)
+            {
+                truck_work += TruckRoute(problem, {0, customer, 0}).working_time();
+                if (problem->customer_arrays.dronable[customer] && _feasible(DroneRoute(problem, {0, customer, 0})))
+                {
+                    dronable.push_back(customer);
+                }
+            }
+
+            std::sort(
+                dronable.begin(), dronable.end(),
+                [&distances](const std::size_t &first, const std::size_t &second)
+                {
+                    return distances[0][first] < distances[0][second];
+                });
+
+            for (auto &customer : dronable)
+            {
+                auto drone_time = DroneRoute(problem, {0, customer, 0}).working_time(),
+                     truck_time = TruckRoute(problem, {0, customer, 0}).working_time();
+                if (problem->trucks_count > 0 &&
+                    (drone_work + drone_time) / problem->drones_count > (truck_work - truck_time) / problem->trucks_count)
+                {
+                    break;
+                }
+
+                drone_work += drone_time;
+                truck_work -= truck_time;
+                by_drone[customer] = true;
+            }
+        }
+
+        std::vector<_Saving> savings;
+        {
+            // Row i holds the n - i pairs (i, j > i), hence rows are split at equal pair counts rather
+            // than equal row counts: threads process rows (bounds[t], bounds[t + 1]].
+            const std::size_t pairs = n * (n - 1) / 2, threads = utils::parallel_threads(pairs, 1 << 14);
+            std::vector<std::size_t> bounds(threads + 1, n);
+            bounds[0] = 0;
+            for (std::size_t thread = 1, row = 0, cumulative = 0; thread < threads; thread++)
+            {
+                while (row < n && cumulative < pairs * thread / threads)
+                {
+                    cumulative += n - ++row;
+                }
+
+                bounds[thread] = row;
+            }
+
+            std::vector<std::vector<_Saving>> partial(threads);
+            utils::parallel_for(
+                threads, 1,
+                [&n, &distances, &by_drone, &bounds, &partial](const std::size_t &, const std::size_t &first, const std::size_t &last)
+                {
+                    for (auto thread = first; thread < last; thread++)
+                    {
+                        for (auto i = bounds[thread] + 1; i <= bounds[thread + 1]; i++)
+                        {
+                            for (auto j = i + 1; j <= n; j++)
+                            {
+                                if (by_drone[i] == by_drone[j])
+                                {
+                                    partial[thread].push_back(_Saving{distances[0][i] + distances[0][j] - distances[i][j], i, j});
+                                }
+                            }
+                        }
+                    }
+                });
+
+            for (auto &p : partial)
+            {
+                savings.insert(savings.end(), p.begin(), p.end());
+            }
+        }
+
+        utils::parallel_sort(
+            savings.begin(), savings.end(),
+            [](const _Saving &first, const _Saving &second)
+            {
+                if (first.value != second.value)
+                {
+                    return first.value > second.value;
+                }
+
+                return first.first != second.first ? first.first < second.first : first.second < second.second;
+            });
+
+        // trips[r] lists the customers of trip r (without the depot), empty once merged into another
+        std::vector<std::vector<std::size_t>> trips(n + 1);
+        std::vector<std::size_t> trip_of(n + 1);
+        for (std::size_t customer = 1; customer <= n; customer++)
+        {
+            trips[customer] = {customer};
+            trip_of[customer] = customer;
+        }
+
+        const auto feasible = [&problem](const std::vector<std::size_t> &customers, const bool &drone)
+        {
+            return drone ? _feasible(DroneRoute(problem, customers)) : _feasible(TruckRoute(problem, customers));
+        };
+
+        std::vector<std::size_t> merged;
+        for (auto &saving : savings)
+        {
+            auto first = trip_of[saving.first], second = trip_of[saving.second];
+            if (first == second)
+            {
+                continue;
+            }
+
+            auto &a = trips[first], &b = trips[second];
+            if ((a.front() != saving.first && a.back() != saving.first) || (b.front() != saving.second && b.back() != saving.second))
+            {
+                continue; // Only trip endpoints can be joined
+            }
+
+            merged.assign(1, 0);
+            if (a.back() == saving.first)
+            {
+                merged.insert(merged.end(), a.begin(), a.end());
+            }
+            else
+            {
+                merged.insert(merged.end(), a.rbegin(), a.rend());
+            }
+
+            if (b.front() == saving.second)
+            {
+                merged.insert(merged.end(), b.begin(), b.end());
+            }
+            else
+            {
+                merged.insert(merged.end(), b.rbegin(), b.rend());
+            }
+
+            merged.push_back(0);
+
+            bool drone = by_drone[saving.first];
+            if (!feasible(merged, drone))
+            {
+                std::reverse(merged.begin(), merged.end());
+                if (!feasible(merged, drone))
+                {
+                    continue;
+                }
+            }
+
+            for (auto &customer : b)
+            {
+                trip_of[customer] = first;
+            }
+
+            a.assign(merged.begin() + 1, merged.end() - 1);
+            b.clear();
+        }
+
+        std::vector<TruckRoute> truck_trips;
+        std::vector<DroneRoute> drone_trips;
+        for (auto &trip : trips)
+        {
+            if (trip.empty())
+            {
+                continue;
+            }
+
+            trip.insert(trip.begin(), 0);
+            trip.push_back(0);
+            if (by_drone[trip[1]])
+            {
+                drone_trips.emplace_back(problem, trip);
+            }
+            else
+            {
+                truck_trips.emplace_back(problem, trip);
+            }
+        }
+
+        return _assign_routes(problem, std::move(truck_trips), std::move(drone_trips));
+    }
+
+    /** @brief The cheapest feasible insertion of a customer into a trip, see `initial_regret` */
+    struct _Insertion
+    {
+        /** @brief Increase of working time, divided by the fleet size. Infinite if infeasible */
+        double cost;
+
+        /** @brief Index in the trip to insert the customer at */
+        std::size_t position;
+    };
+
+    /**
+     * @brief Regret-k cheapest insertion construction.
+     *
+     * Customers are inserted one at a time into trips, the customer with the largest regret first:
+     * the sum of the differences between its `k - 1` next cheapest options and its cheapest one. An
+     * option is the cheapest feasible insertion into an existing trip, or opening a new truck or
+     * drone trip. Costs are working time increases divided by the fleet size of the vehicle type.
+     *
+     * The cheapest insertion of every customer into every trip is cached, so an insertion only
+     * recalculates the entries of the trip it modifies. Customers whose `k` cheapest options are
+     * unaffected keep their regret, and the others are pushed again into a lazily invalidated
+     * priority queue. Finally, trips are assigned longest first to the least loaded vehicle of
+     * their type.
+     *
+     * @param k The number of options considered by the regret, at least 2
+     */
+    inline std::shared_ptr<Solution> initial_regret(const Problem *problem, const std::size_t &k = 2)
+    {
+        const std::size_t n = problem->customers.size() - 1;
+        const double infinity = std::numeric_limits<double>::infinity();
+
+        struct _Trip
+        {
+            bool drone;
+            std::vector<std::size_t> customers;
+            double working_time;
+            double weight;
+        };
+
+        const auto fleet = [&problem](const bool &drone)
+        {
+            return static_cast<double>(drone ? problem->drones_count : problem->trucks_count);
+        };
+
+        // Evaluate `customers`, returning its working time or infinity if infeasible
+        const auto evaluate = [&problem, &infinity](const std::vector<std::size_t> &customers, const bool &drone)
+        {
+            if (drone)
+            {
+                DroneRoute route(problem, customers);
+                return _feasible(route) ? route.working_time() : infinity;
+            }
+
+            TruckRoute route(problem, customers);
+            return _feasible(route) ? route.working_time() : infinity;
+        };
+
+        std::vector<_Trip> trips;
+        std::vector<std::size_t> buffer;
+        const auto cheapest_insertion = [&problem, &infinity, &fleet, &evaluate, &trips, &buffer](const std::size_t &customer, const std::size_t &trip)
+        {
+            _Insertion result{infinity, 0};
+            auto &t = trips[trip];
+            auto capacity = t.drone ? problem->drone->capacity : problem->truck->capacity;
+            if ((t.drone && !problem->customer_arrays.dronable[customer]) || t.weight + problem->customer_arrays.demand[customer] > capacity)
+            {
+                return result;
+            }
+
+            for (std::size_t position = 1; position < t.customers.size(); position++)
+            {
+                buffer.assign(t.customers.begin(), t.customers.end());
+                buffer.insert(buffer.begin() + position, customer);
+
+                double cost = (evaluate(buffer, t.drone) - t.working_time) / fleet(t.drone);
+                if (cost < result.cost)
+                {
+                    result = _Insertion{cost, position};
+                }
+            }
+
+            return result;
+        };
+
+        // Options of opening a new trip: truck_trips[c] and drone_trips[c]
+        std::vector<double> truck_trips(n + 1, infinity), drone_trips(n + 1, infinity);
+        for (std::size_t customer = 1; customer <= n; customer++)
+        {
+            if (problem->trucks_count > 0)
+            {
+                // Always allowed, so that every customer has an option
+                truck_trips[customer] = TruckRoute(problem, {0, customer, 0}).working_time() / fleet(false);
+            }
+
+            if (problem->drones_count > 0 && problem->customer_arrays.dronable[customer])
+            {
+                drone_trips[customer] = evaluate({0, customer, 0}, true) / fleet(true);
+            }
+        }
+
+        // insertions[c][t] is the cheapest insertion of customer c into trip t
+        std::vector<std::vector<_Insertion>> insertions(n + 1);
+        std::vector<bool> inserted(n + 1);
+        inserted[0] = true;
+
+        // The k-th cheapest option cost of each customer when its regret was last calculated
+        std::vector<double> thresholds(n + 1, infinity);
+        std::vector<std::size_t> versions(n + 1);
+
+        // (regret, -cheapest cost, customer, version), the largest regret first
+        using _Entry = std::tuple<double, double, std::size_t, std::size_t>;
+        std::priority_queue<_Entry> queue;
+
+        std::vector<double> costs;
+        const auto update_regret = [&k, &infinity, &truck_trips, &drone_trips, &insertions, &thresholds, &versions, &queue, &costs](const std::size_t &customer)
+        {
+            costs.assign({truck_trips[customer], drone_trips[customer]});
+            for (auto &insertion : insertions[customer])
+            {
+                costs.push_back(insertion.cost);
+            }
+
+            auto top = std::min(k, costs.size());
+            std::partial_sort(costs.begin(), costs.begin() + top, costs.end());
+
+            double regret = 0;
+            for (std::size_t i = 1; i < k; i++)
+            {
+                // Customers with fewer than k feasible options are the most urgent
+                regret += i < top ? costs[i] - costs[0] : infinity;
+            }
+
+            thresholds[customer] = k <= top ? costs[k - 1] : infinity;
+            queue.emplace(std::isnan(regret) ? infinity : regret, -costs[0], customer, ++versions[customer]);
+        };
+
+        for (std::size_t customer = 1; customer <= n; customer++)
+        {
+            update_regret(customer);
+        }
+
+        for (std::size_t remaining = n; remaining > 0;)
+        {
+            auto [regret, negative_cost, customer, version] = queue.top();
+            queue.pop();
+            if (inserted[customer] || version != versions[customer])
+            {
+                continue;
+            }
+
+            // Apply the cheapest option of this customer
+            std::size_t trip = trips.size();
+            double cost = std::min(truck_trips[customer], drone_trips[customer]);
+            for (std::size_t t = 0; t < insertions[customer].size(); t++)
+            {
+                if (insertions[customer][t].cost < cost)
+                {
+                    cost = insertions[customer][t].cost;
+                    trip = t;
+                }
+            }
+
+            if (trip == trips.size())
+            {
+                bool drone = drone_trips[customer] < truck_trips[customer];
+                trips.push_back(_Trip{drone, {0, customer, 0}, 0, 0});
+            }
+            else
+            {
+                auto &t = trips[trip];
+                t.customers.insert(t.customers.begin() + insertions[customer][trip].position, customer);
+            }
+
+            auto &t = trips[trip];
+            t.weight += problem->customer_arrays.demand[customer];
+            t.working_time = t.drone ? DroneRoute(problem, t.customers).working_time() : TruckRoute(problem, t.customers).working_time();
+
+            inserted[customer] = true;
+            remaining--;
+
+            // Only insertions into the modified trip change
+            for (std::size_t other = 1; other <= n; other++)
+            {
+                if (inserted[other])
+                {
+                    continue;
+                }
+
+                auto old_cost = trip < insertions[other].size() ? insertions[other][trip].cost : infinity;
+                auto insertion = cheapest_insertion(other, trip);
+                if (trip < insertions[other].size())
+                {
+                    insertions[other][trip] = insertion;
+                }
+                else
+                {
+                    insertions[other].push_back(insertion);
+                }
+
+                if (old_cost <= thresholds[other] || insertion.cost <= thresholds[other])
+                {
+                    update_regret(other);
+                }
+            }
+        }
+
+        std::vector<TruckRoute> truck_routes;
+        std::vector<DroneRoute> drone_routes;
+        for (auto &trip : trips)
+        {
+            if (trip.drone)
+            {
+                drone_routes.emplace_back(problem, trip.customers);
+            }
+            else
+            {
+                truck_routes.emplace_back(problem, trip.customers);
+            }
+        }
+
+        return _assign_routes(problem, std::move(truck_routes), std::move(drone_routes));
     }
 
 #undef INITIAL_12_PHASE_3
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "format.hpp"
+
+namespace utils
+{
+    enum class JsonType
+    {
+        null,
+        boolean,
+        number,
+        string,
+        array,
+        object
+    };
+
+    /**
+     * @brief A minimal JSON value, sufficient for reading the configuration files in
+     * `problems/config_parameter`.
+     *
+     * Object members are kept in document order, which matters for e.g. the truck speed
+     * coefficients.
+     */
+    class JsonValue
+    {
+    private:
+        class _Parser;
+
+    public:
+        JsonType type = JsonType::null;
+        bool boolean = false;
+        double number = 0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        /** @brief Find a member of an object, or `nullptr` if it does not exist. */
+        const JsonValue *find(const std::string_view &key) const
+        {
+            for (auto &[k, v] : object)
+            {
+                if (k == key)
+                {
+                    return &v;
+                }
+            }
+
+            return nullptr;
+        }
+
+        /**
+         * @brief Get a member of an object.
+         * @note `std::runtime_error` is thrown if the member does not exist.
+         */
+        const JsonValue &operator[](const std::string_view &key) const
+        {
+            auto value = find(key);
+            if (value == nullptr)
+            {
+                throw std::runtime_error(format("Missing JSON key \"%s\"", std::string(key).c_str()));
+            }
+
+            return *value;
+        }
+
+        /**
+         * @brief Get the numeric value.
+         * @note `std::runtime_error` is thrown if this value is not a number.
+         */
+        double as_number() const
+        {
+            if (type != JsonType::number)
+            {
+                throw std::runtime_error("JSON value is not a number");
+            }
+
+            return number;
+        }
+
+        /**
+         * @brief Get the string value.
+         * @note `std::runtime_error` is thrown if this value is not a string.
+         */
+        const std::string &as_string() const
+        {
+            if (type != JsonType::string)
+            {
+                throw std::runtime_error("JSON value is not a string");
+            }
+
+            return string;
+        }
+
+        /**
+         * @brief Parse a JSON document.
+         * @note `std::runtime_error` is thrown on malformed input.
+         */
+        static JsonValue parse(const std::string_view &text);
+    };
+
+    class JsonValue::_Parser
+    {
+    private:
+        const std::string_view _text;
+        std::size_t _position = 0;
+
+        [[noreturn]] void _fail(const char *message) const
+        {
+            throw std::runtime_error(format("Malformed JSON at offset %lu: %s", _position, message));
+        }
+
+        void _skip_whitespace()
+        {
+            while (_position < _text.size() && std::isspace(static_cast<unsigned char>(_text[_position])))
+            {
+                _position++;
+            }
+        }
+
+        void _expect(const char c)
+        {
+            _skip_whitespace();
+            if (_position >= _text.size() || _text[_position] != c)
+            {
+                _fail(format("expected '%c'", c).c_str());
+            }
+
+            _position++;
+        }
+
+        bool _consume(const std::string_view &literal)
+        {
+            if (_text.substr(_position, literal.size()) == literal)
+            {
+                _position += literal.size();
+                return true;
+            }
+
+            return false;
+        }
+
+        std::string _parse_string()
+        {
+            _expect('"');
+            std::string result;
+            while (_position < _text.size() && _text[_position] != '"')
+            {
+                char c = _text[_position++];
+                if (c == '\\')
+                {
+                    if (_position >= _text.size())
+                    {
+                        break;
+                    }
+
+                    c = _text[_position++];
+                    switch (c)
+                    {
+                    case 'n':
+                        c = '\n';
+                        break;
+                    case 't':
+                        c = '\t';
+                        break;
+                    case 'r':
+                        c = '\r';
+                        break;
+                    case 'b':
+                        c = '\b';
+                        break;
+                    case 'f':
+                        c = '\f';
+                        break;
+                    case 'u':
+                        _fail("unicode escapes are not supported");
+                    default: // '"', '\\' and '/' map to themselves
+                        break;
+                    }
+                }
+
+                result.push_back(c);
+            }
+
+            _expect('"');
+            return result;
+        }
+
+        double _parse_number()
+        {
+            double value;
+            auto begin = _text.data() + _position, end = _text.data() + _text.size();
+            auto [ptr, ec] = std::from_chars(begin, end, value);
+            if (ec != std::errc())
+            {
+                _fail("invalid number");
+            }
+
+            _position += ptr - begin;
+            return value;
+        }
+
+    public:
+        _Parser(const std::string_view &text) : _text(text) {}
+
+        JsonValue parse_value()
+        {
+            JsonValue value;
+
+            _skip_whitespace();
+            if (_position >= _text.size())
+            {
+                _fail("unexpected end of input");
+            }
+
+            char c = _text[_position];
+            if (c == '{')
+            {
+                value.type = JsonType::object;
+                _position++;
+                _skip_whitespace();
+                if (_position < _text.size() && _text[_position] == '}')
+                {
+                    _position++;
+                    return value;
+                }
+
+                do
+                {
+                    auto key = _parse_string();
+                    _expect(':');
+                    value.object.emplace_back(key, parse_value());
+                    _skip_whitespace();
+                } while (_position < _text.size() && _text[_position] == ',' && ++_position);
+
+                _expect('}');
+            }
+            else if (c == '[')
+            {
+                value.type = JsonType::array;
+                _position++;
+                _skip_whitespace();
+                if (_position < _text.size() && _text[_position] == ']')
+                {
+                    _position++;
+                    return value;
+                }
+
+                do
+                {
+                    value.array.push_back(parse_value());
+                    _skip_whitespace();
+                } while (_position < _text.size() && _text[_position] == ',' && ++_position);
+
+                _expect(']');
+            }
+            else if (c == '"')
+            {
+                value.type = JsonType::string;
+                value.string = _parse_string();
+            }
+            else if (_consume("true") || _consume("false"))
+            {
+                value.type = JsonType::boolean;
+                value.boolean = c == 't';
+            }
+            else if (_consume("null"))
+            {
+                value.type = JsonType::null;
+            }
+            else
+            {
+                value.type = JsonType::number;
+                value.number = _parse_number();
+            }
+
+            return value;
+        }
+
+        void finish()
+        {
+            _skip_whitespace();
+            if (_position != _text.size())
+            {
+                _fail("trailing characters");
+            }
+        }
+    };
+
+    inline JsonValue JsonValue::parse(const std::string_view &text)
+    {
+        _Parser parser(text);
+        auto value = parser.parse_value();
+        parser.finish();
+        return value;
+    }
+}
@@ -0,0 +1,572 @@
+#pragma once
+
+#include "cache.hpp"
+#include "json.hpp"
+#include "mapped_file.hpp"
+#include "problem.hpp"
+#include "timings.hpp"
+
+namespace d2d
+{
+    /**
+     * @brief Command-line options selecting a problem instance and its configuration.
+     *
+     * The options and their defaults mirror `scripts/transform.py`.
+     */
+    class ProblemOptions
+    {
+    public:
+        /** @brief Name of an instance in `<root>/data`, or a path to an instance file */
+        std::string problem;
+
+        std::size_t iterations = 100;
+        std::size_t tabu_size = 10;
+
+        /** @brief The energy consumption model: "linear", "non-linear" or "endurance" */
+        std::string config = "linear";
+
+        /** @brief Speed type of drones: "low" or "high" */
+        std::string speed_type = "low";
+
+        /** @brief Range type of drones: "low" or "high" */
+        std::string range_type = "low";
+
+        bool verbose = false;
+
+        /** @brief Progress output in verbose mode: "terminal", "log" or "json" */
+        std::string progress = "terminal";
+
+        /** @brief Seed of the random number generator, unset to seed from the clock */
+        std::optional<std::uint32_t> seed;
+
+        /** @brief CSV file to record every iteration of the search to, empty to disable */
+        std::string trace;
+
+        /** @brief Output format of the solution: "text" or "json" */
+        std::string format = "text";
+
+        /** @brief Directory containing the `data` and `config_parameter` folders */
+        std::string root = "problems";
+
+        /** @brief Directory of binary instance caches, empty to always load from text */
+        std::string cache;
+
+        /** @brief Verification of debug builds: "invariants", "sampled" or "full" */
+        std::string checks = "full";
+
+        /** @brief With sampled checks, fully verify 1 in every `check_period` mutations */
+        std::size_t check_period = 100;
+
+        /**
+         * @brief Parse command-line arguments.
+         * @note `std::invalid_argument` is thrown on unknown or malformed arguments.
+         */
+        static ProblemOptions parse(const std::vector<std::string> &args);
+
+        /** @brief The usage message describing the accepted arguments. */
+        static std::string usage();
+
+        /** @brief Path to the instance file. */
+        std::string instance_path() const;
+
+        /** @brief Name of the instance, without directories and extension. */
+        std::string instance_name() const;
+
+        /** @brief Path to the binary cache of the instance. */
+        std::string cache_path() const;
+    };
+
+    template <typename T>
+    T _parse_number(const std::string_view &token)
+    {
+        T value;
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (ec != std::errc() || ptr != token.data() + token.size())
+        {
+            throw std::invalid_argument(utils::format("Expected a number, got \"%s\"", std::string(token).c_str()));
+        }
+
+        return value;
+    }
+
+    /**
+     * @brief Parse a number read from a file.
+     * @note `std::runtime_error` naming the file is thrown on malformed tokens, since bad file contents are
+     * not a usage error.
+     */
+    template <typename T>
+    T _parse_number(const std::string_view &token, const std::string &path)
+    {
+        try
+        {
+            return _parse_number<T>(token);
+        }
+        catch (std::invalid_argument &e)
+        {
+            throw std::runtime_error(utils::format("%s in \"%s\"", e.what(), path.c_str()));
+        }
+    }
+
+    inline ProblemOptions ProblemOptions::parse(const std::vector<std::string> &args)
+    {
+        ProblemOptions options;
+        const auto value = [&args](std::size_t &i) -> const std::string &
+        {
+            if (i + 1 >= args.size())
+            {
+                throw std::invalid_argument(utils::format("Missing value for argument %s", args[i].c_str()));
+            }
+
+            return args[++i];
+        };
+
+        const auto choice = [&args, &value](std::size_t &i, const std::vector<std::string> &choices)
+        {
+            auto &v = value(i);
+            if (std::find(choices.begin(), choices.end(), v) == choices.end())
+            {
+                throw std::invalid_argument(utils::format("Invalid value \"%s\" for argument %s", v.c_str(), args[i - 1].c_str()));
+            }
+
+            return v;
+        };
+
+        for (std::size_t i = 0; i < args.size(); i++)
+        {
+            auto &arg = args[i];
+            if (arg == "-i" || arg == "--iterations")
+            {
+                options.iterations = _parse_number<std::size_t>(value(i));
+            }
+            else if (arg == "-t" || arg == "--tabu-size")
+            {
+                options.tabu_size = _parse_number<std::size_t>(value(i));
+            }
+            else if (arg == "-c" || arg == "--config")
+            {
+                options.config = choice(i, {"linear", "non-linear", "endurance"});
+            }
+            else if (arg == "--speed-type")
+            {
+                options.speed_type = choice(i, {"low", "high"});
+            }
+            else if (arg == "--range-type")
+            {
+                options.range_type = choice(i, {"low", "high"});
+            }
+            else if (arg == "-v" || arg == "--verbose")
+            {
+                options.verbose = true;
+            }
+            else if (arg == "--progress")
+            {
+                options.progress = choice(i, {"terminal", "log", "json"});
+                options.verbose = true;
+            }
+            else if (arg == "--seed")
+            {
+                options.seed = _parse_number<std::uint32_t>(value(i));
+            }
+            else if (arg == "--trace")
+            {
+                options.trace = value(i);
+            }
+            else if (arg == "--format")
+            {
+                options.format = choice(i, {"text", "json"});
+            }
+            else if (arg == "--root")
+            {
+                options.root = value(i);
+            }
+            else if (arg == "--cache")
+            {
+                options.cache = value(i);
+            }
+            else if (arg == "--checks")
+            {
+                options.checks = choice(i, {"invariants", "sampled", "full"});
+            }
+            else if (arg == "--check-period")
+            {
+                options.check_period = _parse_number<std::size_t>(value(i));
+            }
+            else if (!arg.empty() && arg.front() != '-' && options.problem.empty())
+            {
+                options.problem = arg;
+            }
+            else
+            {
+                throw std::invalid_argument(utils::format("Unrecognized argument %s", arg.c_str()));
+            }
+        }
+
+        if (options.problem.empty())
+        {
+            throw std::invalid_argument("Missing problem name");
+        }
+
+        return options;
+    }
+
+    inline std::string ProblemOptions::usage()
+    {
+        return "Usage: main.exe <problem> [-i ITERATIONS] [-t TABU_SIZE] [-c {linear,non-linear,endurance}]\n"
+               "                [--speed-type {low,high}] [--range-type {low,high}] [-v] [--root DIRECTORY]\n"
+               "                [--progress {terminal,log,json}] [--seed SEED] [--format {text,json}]\n"
+               "                [--cache DIRECTORY] [--trace PATH]\n"
+               "                [--checks {invariants,sampled,full}] [--check-period PERIOD]\n"
+               "       main.exe --batch <manifest> [--threads COUNT] [--output PATH]\n"
+               "                [--checks {invariants,sampled,full}] [--check-period PERIOD]\n"
+               "       main.exe < input.txt\n";
+    }
+
+    inline std::string ProblemOptions::instance_path() const
+    {
+        std::ifstream file(problem);
+        if (file)
+        {
+            return problem;
+        }
+
+        auto name = problem;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0)
+        {
+            name.resize(name.size() - 4);
+        }
+
+        return root + "/data/" + name + ".txt";
+    }
+
+    inline std::string ProblemOptions::instance_name() const
+    {
+        std::size_t begin = problem.find_last_of("/\\"), end = problem.find_last_of('.');
+        begin = begin == std::string::npos ? 0 : begin + 1;
+        if (end == std::string::npos || end < begin || problem.compare(end, std::string::npos, ".txt") != 0)
+        {
+            end = problem.size();
+        }
+
+        return problem.substr(begin, end - begin);
+    }
+
+    inline std::string ProblemOptions::cache_path() const
+    {
+        return cache + "/" + instance_name() + ".d2d";
+    }
+
+    /** @brief Splits a character range into whitespace-separated tokens without copying. */
+    class _Tokenizer
+    {
+    private:
+        const std::string_view _text;
+        std::size_t _position = 0;
+
+    public:
+        _Tokenizer(const std::string_view &text) : _text(text) {}
+
+        /** @brief The next token, or an empty view at the end of input. */
+        std::string_view next()
+        {
+            while (_position < _text.size() && std::isspace(static_cast<unsigned char>(_text[_position])))
+            {
+                _position++;
+            }
+
+            std::size_t begin = _position;
+            while (_position < _text.size() && !std::isspace(static_cast<unsigned char>(_text[_position])))
+            {
+                _position++;
+            }
+
+            return _text.substr(begin, _position - begin);
+        }
+    };
+
+    /**
+     * @brief Read the customers of an instance file in `problems/data`.
+     *
+     * The file starts with `key value` lines (`number_staff`, `number_drone`, `Customers`, ...) and a
+     * column header, followed by one row `x y demand truck_only truck_service_time drone_service_time`
+     * per customer.
+     *
+     * @return The customers, starting with the depot `0`
+     */
+    inline std::vector<Customer> _load_customers(const std::string &path, std::size_t &trucks_count, std::size_t &drones_count)
+    {
+        utils::MappedFile file(path);
+        _Tokenizer tokenizer(file.view());
+
+        std::optional<std::size_t> customers_count, trucks, drones;
+        std::string_view token;
+        const auto is_number = [](const std::string_view &token)
+        {
+            double value;
+            auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+            return ec == std::errc() && ptr == token.data() + token.size();
+        };
+
+        // Header: key-value pairs, then the column names until the first number
+        while (!(token = tokenizer.next()).empty() && !(customers_count.has_value() && is_number(token)))
+        {
+            if (token == "number_staff")
+            {
+                trucks = _parse_number<std::size_t>(tokenizer.next(), path);
+            }
+            else if (token == "number_drone")
+            {
+                drones = _parse_number<std::size_t>(tokenizer.next(), path);
+            }
+            else if (token == "Customers")
+            {
+                customers_count = _parse_number<std::size_t>(tokenizer.next(), path);
+            }
+        }
+
+        if (!customers_count.has_value() || !trucks.has_value() || !drones.has_value())
+        {
+            throw std::runtime_error(utils::format("Missing instance header in \"%s\"", path.c_str()));
+        }
+
+        trucks_count = trucks.value();
+        drones_count = drones.value();
+
+        std::vector<Customer> customers;
+        customers.reserve(customers_count.value() + 1);
+        customers.push_back(Customer::depot());
+        for (std::size_t i = 0; i < customers_count.value(); i++)
+        {
+            double row[6];
+            for (std::size_t j = 0; j < 6; j++)
+            {
+                if (i > 0 || j > 0) // the first number was consumed by the header loop
+                {
+                    token = tokenizer.next();
+                }
+
+                if (token.empty())
+                {
+                    throw std::runtime_error(utils::format("Expected %lu customers in \"%s\", got %lu", customers_count.value(), path.c_str(), i));
+                }
+
+                row[j] = _parse_number<double>(token, path);
+            }
+
+            customers.emplace_back(row[0], row[1], row[2], row[3] == 0, row[4], row[5]);
+        }
+
+        return customers;
+    }
+
+    /**
+     * @brief Parse a JSON file and read values from it.
+     * @note Errors from the JSON parser or the reader are rethrown as `std::runtime_error` naming the file.
+     */
+    template <typename _Reader>
+    auto _read_json(const std::string &path, const _Reader &reader)
+    {
+        utils::MappedFile file(path);
+        try
+        {
+            return reader(utils::JsonValue::parse(file.view()));
+        }
+        catch (std::runtime_error &e)
+        {
+            throw std::runtime_error(utils::format("%s in \"%s\"", e.what(), path.c_str()));
+        }
+    }
+
+    inline TruckConfig *_load_truck_config(const ProblemOptions &options)
+    {
+        return _read_json(
+            options.root + "/config_parameter/truck_config.json",
+            [](const utils::JsonValue &data)
+            {
+                std::vector<double> coefficients;
+                for (auto &[_, coefficient] : data["T (hour)"].object)
+                {
+                    coefficients.push_back(coefficient.as_number());
+                }
+
+                return new TruckConfig(data["V_max (m/s)"].as_number(), coefficients, data["M_t (kg)"].as_number());
+            });
+    }
+
+    inline _BaseDroneConfig *_load_drone_config(const ProblemOptions &options)
+    {
+        std::string file = options.config == "linear"       ? "drone_linear_config.json"
+                           : options.config == "non-linear" ? "drone_nonlinear_config.json"
+                                                            : "drone_endurance_config.json";
+        return _read_json(
+            options.root + "/config_parameter/" + file,
+            [&options](const utils::JsonValue &data) -> _BaseDroneConfig *
+            {
+                for (auto &[_, model] : data.object)
+                {
+                    if (model.type != utils::JsonType::object ||
+                        model["speed_type"].as_string() != options.speed_type ||
+                        model["range"].as_string() != options.range_type)
+                    {
+                        continue;
+                    }
+
+                    double capacity = model["capacity [kg]"].as_number();
+                    StatsType speed_type = options.speed_type == "low" ? StatsType::low : StatsType::high,
+                              range_type = options.range_type == "low" ? StatsType::low : StatsType::high;
+
+                    if (options.config == "endurance")
+                    {
+                        return new DroneEnduranceConfig(
+                            capacity,
+                            speed_type,
+                            range_type,
+                            model["FixedTime (s)"].as_number(),
+                            model["FixedDistance (m)"].as_number(),
+                            model["Drone_speed (m/s)"].as_number());
+                    }
+
+                    double takeoff_speed = model["takeoffSpeed [m/s]"].as_number(),
+                           cruise_speed = model["cruiseSpeed [m/s]"].as_number(),
+                           landing_speed = model["landingSpeed [m/s]"].as_number(),
+                           altitude = model["cruiseAlt [m]"].as_number(),
+                           battery = model["batteryPower [Joule]"].as_number();
+
+                    if (options.config == "linear")
+                    {
+                        return new DroneLinearConfig(
+                            capacity,
+                            speed_type,
+                            range_type,
+                            takeoff_speed,
+                            cruise_speed,
+                            landing_speed,
+                            altitude,
+                            battery,
+                            model["beta(w/kg)"].as_number(),
+                            model["gamma(w)"].as_number());
+                    }
+
+                    // The non-linear coefficients are shared by all models, at the top level
+                    return new DroneNonlinearConfig(
+                        capacity,
+                        speed_type,
+                        range_type,
+                        takeoff_speed,
+                        cruise_speed,
+                        landing_speed,
+                        altitude,
+                        battery,
+                        data["k1"].as_number(),
+                        data["k2 (sqrt(kg/m)"].as_number(),
+                        data["c1 (sqrt(m/kg)"].as_number(),
+                        data["c2 (sqrt(m/kg)"].as_number(),
+                        data["c4 (kg/m)"].as_number(),
+                        data["c5 (Ns/m)"].as_number());
+                }
+
+                throw std::runtime_error(
+                    utils::format(
+                        "Cannot find a %s drone model with speed type \"%s\" and range type \"%s\"",
+                        options.config.c_str(), options.speed_type.c_str(), options.range_type.c_str()));
+            });
+    }
+
+    /**
+     * @brief Load a problem directly from the instance and configuration files.
+     *
+     * This is the native equivalent of piping `scripts/transform.py` into `Problem::read`. When a
+     * cache directory is set, the instance is read from its binary cache instead, which is (re)built
+     * from the text file if it is missing, stale or unreadable.
+     *
+     * @param timings If not `nullptr`, records the duration of each loading phase
+     */
+    inline std::unique_ptr<Problem> load_problem(const ProblemOptions &options, utils::PhaseTimings *timings = nullptr)
+    {
+        auto source = options.instance_path();
+
+        std::unique_ptr<TruckConfig> truck;
+        std::unique_ptr<_BaseDroneConfig> drone;
+        utils::PhaseTimings::measure(
+            timings,
+            "parse_config",
+            [&options, &truck, &drone]()
+            {
+                truck.reset(_load_truck_config(options));
+                drone.reset(_load_drone_config(options));
+            });
+
+        if (!options.cache.empty() && std::filesystem::exists(options.cache_path()))
+        {
+            try
+            {
+                auto problem = utils::PhaseTimings::measure(
+                    timings,
+                    "load_cache",
+                    [&options, &source, &truck, &drone]()
+                    {
+                        InstanceCache cache(options.cache_path());
+                        return cache.is_fresh(source)
+                                   ? Problem::create(
+                                         options.iterations,
+                                         options.tabu_size,
+                                         options.verbose,
+                                         cache.trucks_count(),
+                                         cache.drones_count(),
+                                         cache.customers(),
+                                         cache.distances(),
+                                         std::move(truck),
+                                         std::move(drone))
+                                   : nullptr;
+                    });
+
+                if (problem != nullptr)
+                {
+                    return problem;
+                }
+            }
+            catch (std::runtime_error &)
+            {
+                // Fall back to the text file and rebuild the cache
+            }
+        }
+
+        std::size_t trucks_count, drones_count;
+        auto customers = utils::PhaseTimings::measure(
+            timings,
+            "parse",
+            [&source, &trucks_count, &drones_count]()
+            {
+                return _load_customers(source, trucks_count, drones_count);
+            });
+
+        auto problem = utils::PhaseTimings::measure(
+            timings,
+            "matrix",
+            [&]()
+            {
+                return Problem::create(
+                    options.iterations,
+                    options.tabu_size,
+                    options.verbose,
+                    trucks_count,
+                    drones_count,
+                    customers,
+                    std::move(truck),
+                    std::move(drone));
+            });
+
+        if (!options.cache.empty())
+        {
+            utils::PhaseTimings::measure(
+                timings,
+                "write_cache",
+                [&options, &source, &problem]()
+                {
+                    std::filesystem::create_directories(options.cache);
+                    InstanceCache::write(options.cache_path(), source, *problem);
+                });
+        }
+
+        return problem;
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "format.hpp"
+
+namespace utils
+{
+    /**
+     * @brief A read-only view of a whole file, backed by
+     * [`mmap`](https://man7.org/linux/man-pages/man2/mmap.2.html) where available.
+     *
+     * On platforms without `mmap`, the file content is read into an owned buffer instead.
+     * The view remains valid for the lifetime of this object.
+     */
+    class MappedFile
+    {
+    private:
+        const char *_data = nullptr;
+        std::size_t _size = 0;
+
+#if !defined(__linux__)
+        std::vector<char> _buffer;
+#endif
+
+    public:
+        /**
+         * @brief Map the file at `path`.
+         * @note `std::runtime_error` is thrown if the file cannot be opened or mapped.
+         */
+        MappedFile(const std::string &path)
+        {
+#if defined(__linux__)
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd == -1)
+            {
+                throw std::runtime_error(format("Unable to open \"%s\"", path.c_str()));
+            }
+
+            struct stat info;
+            if (fstat(fd, &info) == -1)
+            {
+                close(fd);
+                throw std::runtime_error(format("Unable to stat \"%s\"", path.c_str()));
+            }
+
+            _size = info.st_size;
+            if (_size > 0)
+            {
+                void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED)
+                {
+                    close(fd);
+                    throw std::runtime_error(format("Unable to map \"%s\"", path.c_str()));
+                }
+
+                _data = static_cast<const char *>(data);
+            }
+
+            close(fd); // The mapping stays valid after closing the descriptor
+#else
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+            {
+                throw std::runtime_error(format("Unable to open \"%s\"", path.c_str()));
+            }
+
+            _buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            _data = _buffer.data();
+            _size = _buffer.size();
+#endif
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile()
+        {
+#if defined(__linux__)
+            if (_data != nullptr)
+            {
+                munmap(const_cast<char *>(_data), _size);
+            }
+#endif
+        }
+
+        /** @brief Pointer to the first byte of the file */
+        const char *data() const
+        {
+            return _data;
+        }
+
+        /** @brief Size of the file in bytes */
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        /** @brief The file content as a `std::string_view` */
+        std::string_view view() const
+        {
+            return std::string_view(_data, _size);
+        }
+    };
+}
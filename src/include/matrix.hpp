@@ -0,0 +1,85 @@
+#pragma once
+
+#include "format.hpp"
+
+namespace utils
+{
+    /**
+     * @brief A dense square matrix stored contiguously in row-major order.
+     *
+     * The storage is either owned or borrowed from an external buffer (e.g. a memory-mapped file),
+     * in which case `owner` keeps that buffer alive for the lifetime of the matrix. Element access
+     * `matrix[i][j]` performs a single indirection.
+     *
+     * @tparam T The element type
+     */
+    template <typename T>
+    class SquareMatrix
+    {
+    private:
+        std::size_t _size;
+        std::vector<T> _storage;
+        std::shared_ptr<const void> _owner;
+        const T *_data;
+
+    public:
+        /** @brief Construct an owned `size x size` matrix filled with `value`. */
+        SquareMatrix(const std::size_t &size, const T &value = T())
+            : _size(size),
+              _storage(size * size, value),
+              _data(_storage.data()) {}
+
+        /**
+         * @brief Construct a matrix viewing `size x size` elements at `data`.
+         *
+         * @param owner An object keeping `data` alive
+         */
+        SquareMatrix(const std::size_t &size, const T *data, const std::shared_ptr<const void> &owner)
+            : _size(size),
+              _owner(owner),
+              _data(data) {}
+
+        SquareMatrix(const SquareMatrix<T> &other)
+            : _size(other._size),
+              _storage(other._storage),
+              _owner(other._owner),
+              _data(other._owner == nullptr ? _storage.data() : other._data) {}
+
+        SquareMatrix(SquareMatrix<T> &&other)
+            : _size(other._size),
+              _storage(std::move(other._storage)),
+              _owner(std::move(other._owner)),
+              _data(_owner == nullptr ? _storage.data() : other._data) {}
+
+        SquareMatrix<T> &operator=(const SquareMatrix<T> &) = delete;
+
+        /** @brief The number of rows (and columns) */
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        /** @brief Pointer to the first element of row `row` */
+        const T *operator[](const std::size_t &row) const
+        {
+            return _data + row * _size;
+        }
+
+        /** @brief Pointer to the first element of row `row`, only available for owned storage */
+        T *row(const std::size_t &row)
+        {
+            if (_owner != nullptr)
+            {
+                throw std::runtime_error("Cannot modify a borrowed SquareMatrix");
+            }
+
+            return _storage.data() + row * _size;
+        }
+
+        /** @brief Pointer to the contiguous storage of `size() * size()` elements */
+        const T *data() const
+        {
+            return _data;
+        }
+    };
+}
@@ -1,27 +1,107 @@
 #pragma once
 
 #include "../problem.hpp"
+#include "../telemetry.hpp"
+#include "../tournament_tree.hpp"
 
 namespace d2d
 {
     /**
      * @brief Base class for local search neighborhoods
+     *
+     * Neighborhoods are dispatched statically, each derived class must provide a member template
+     *
+     * @code
+     * template <typename _AspirationCriteria>
+     * std::shared_ptr<ST> move(const std::shared_ptr<ST> &solution, const _AspirationCriteria &aspiration_criteria);
+     * @endcode
+     *
+     * which performs a local search to find the best solution in the neighborhood. `aspiration_criteria`
+     * is the aspiration criteria of tabu search, it should return `true` if the solution satisfies the
+     * aspiration criteria, `false` otherwise. The returned value is the best solution found that is not
+     * `solution`, or `nullptr` if the neighborhood is empty.
+     *
+     * Each derived class must also provide a `static std::string label()` naming the neighborhood in
+     * reports.
      */
     template <typename ST>
     class Neighborhood
     {
-    public:
+    protected:
+        /**
+         * @brief The total working time of a vehicle with trips `routes`, summed in the same order as
+         * `ST` so that both agree exactly.
+         */
+        template <typename RT>
+        static double vehicle_working_time(const std::vector<RT> &routes)
+        {
+            double result = 0;
+            for (auto &route : routes)
+            {
+                result += route.working_time();
+            }
+
+            return result;
+        }
+
+        /**
+         * @brief The working times of all vehicles of `solution`, trucks first. Its maximum is the
+         * working time of `solution`.
+         */
+        static utils::TournamentTree<double> vehicle_working_times(const ST &solution)
+        {
+            std::vector<double> working_times;
+            for (auto &routes : solution.truck_routes)
+            {
+                working_times.push_back(vehicle_working_time(routes));
+            }
+
+            for (auto &routes : solution.drone_routes)
+            {
+                working_times.push_back(vehicle_working_time(routes));
+            }
+
+            return utils::TournamentTree<double>(working_times.begin(), working_times.end());
+        }
+
         /**
-         * @brief Perform a local search to find the best solution in the neighborhood.
+         * @brief Whether a candidate solution with vehicle working times `working_times` may be better
+         * than `result`, the best candidate so far.
          *
-         * @param solution A shared pointer to the current solution
-         * @param aspiration_criteria The aspiration criteria of tabu search. This function should return `true`
-         * if the solution satisfies the aspiration criteria, `false` otherwise
-         * @return The best solution found that is not `solution`, or `nullptr` if the neighborhood is empty
+         * The cost of a solution is never less than its working time, hence candidates failing this
+         * test do not need to be constructed.
+         *
+         * @note Time complexity `O(1)`
          */
-        virtual std::shared_ptr<ST> move(
-            const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria) = 0;
+        static bool may_improve(const std::shared_ptr<ST> &result, const utils::TournamentTree<double> &working_times)
+        {
+            if (result == nullptr || working_times.max() < result->cost())
+            {
+                return true;
+            }
+
+            TELEMETRY_COUNT(pruned_candidates[utils::telemetry.neighborhood]);
+            return false;
+        }
+
+        /** @brief Verify that `working_times` describes the constructed `candidate`. */
+        static void check_working_times(const ST &candidate, const utils::TournamentTree<double> &working_times)
+        {
+#ifdef DEBUG
+            if (candidate.working_time != std::max(working_times.max(), 0.0))
+            {
+                throw std::runtime_error(utils::format(
+                    "Inconsistent vehicle working times: %lf != %lf",
+                    working_times.max(), candidate.working_time));
+            }
+#endif
+        }
+
+    public:
+        /** @brief The problem context this neighborhood operates on */
+        const Problem *problem;
+
+        Neighborhood(const Problem *problem) : problem(problem) {}
     };
 
     template <typename ST>
@@ -36,15 +116,18 @@ namespace d2d
          */
         std::vector<tabu_pair> tabu_list;
 
+        tabu_pair _last_move;
+
     protected:
         void add_to_tabu(const std::size_t &first, const std::size_t &second)
         {
-            auto problem = Problem::get_instance();
             tabu_pair p = std::minmax(first, second);
+            _last_move = p;
+
             auto tabu_iter = std::find(tabu_list.begin(), tabu_list.end(), p);
             if (tabu_iter == tabu_list.end())
             {
-                if (tabu_list.size() == problem->tabu_size)
+                if (tabu_list.size() == this->problem->tabu_size)
                 {
                     tabu_list.erase(tabu_list.begin());
                 }
@@ -61,24 +144,61 @@ namespace d2d
             tabu_pair p = std::minmax(first, second);
             return std::find(tabu_list.begin(), tabu_list.end(), p) != tabu_list.end();
         }
+
+        /**
+         * @brief Whether a candidate solution reached by a move with tabu pair `(first, second)` may be
+         * accepted: the move is not tabu, or the candidate satisfies the aspiration criteria.
+         */
+        template <typename _AspirationCriteria>
+        bool is_admissible(
+            const ST &candidate,
+            const std::size_t &first,
+            const std::size_t &second,
+            const _AspirationCriteria &aspiration_criteria) const
+        {
+            TELEMETRY_COUNT(candidates[utils::telemetry.neighborhood]);
+            if (!is_tabu(first, second))
+            {
+                return true;
+            }
+
+            if (aspiration_criteria(candidate))
+            {
+                TELEMETRY_COUNT(aspiration_overrides);
+                return true;
+            }
+
+            TELEMETRY_COUNT(tabu_rejections);
+            return false;
+        }
+
+    public:
+        TabuPairNeighborhood(const Problem *problem) : Neighborhood<ST>(problem) {}
+
+        /** @brief The tabu pair of the latest move, i.e. the customers it involves */
+        const tabu_pair &last_move() const
+        {
+            return _last_move;
+        }
     };
 
-    template <typename ST>
+    /**
+     * @brief Base class for neighborhoods exploring moves within a route and between a pair of routes
+     *
+     * @tparam _Derived The derived class (CRTP), which must provide `same_route` and `multi_route`
+     * member templates with the same signature as `move`, returning the best solution together with
+     * the tabu pair of the corresponding move.
+     */
+    template <typename ST, typename _Derived>
     class CommonRouteNeighborhood : public TabuPairNeighborhood<ST>
     {
-    private:
-        virtual std::pair<std::shared_ptr<ST>, std::pair<std::size_t, std::size_t>> same_route(
-            const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria) = 0;
-
-        virtual std::pair<std::shared_ptr<ST>, std::pair<std::size_t, std::size_t>> multi_route(
-            const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria) = 0;
-
     public:
-        virtual std::shared_ptr<ST> move(
+        CommonRouteNeighborhood(const Problem *problem) : TabuPairNeighborhood<ST>(problem) {}
+
+        template <typename _AspirationCriteria>
+        std::shared_ptr<ST> move(
             const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria) override final
+            const _AspirationCriteria &aspiration_criteria)
         {
             std::shared_ptr<ST> result;
             std::pair<std::size_t, std::size_t> tabu_pair;
@@ -92,8 +212,9 @@ namespace d2d
                 }
             };
 
-            update(same_route(solution, aspiration_criteria));
-            update(multi_route(solution, aspiration_criteria));
+            auto derived = static_cast<_Derived *>(this);
+            update(derived->same_route(solution, aspiration_criteria));
+            update(derived->multi_route(solution, aspiration_criteria));
 
             this->add_to_tabu(tabu_pair.first, tabu_pair.second);
 
@@ -0,0 +1,360 @@
+#pragma once
+
+#include "abc.hpp"
+#include "../routes.hpp"
+
+namespace d2d
+{
+    /**
+     * @brief CROSS-exchange: swap a segment of up to `L` customers of a route with a segment of up to
+     * `L` customers of another route, each optionally reversed.
+     *
+     * One of the segments may be empty, which relocates the other one. All pairs of routes are
+     * explored, including routes of the same vehicle and truck-drone pairs.
+     *
+     * Candidates are screened in `O(1)` each from segment aggregates (prefix sums of distances,
+     * demands and non-dronable customers): the new distance of both routes is exact, their working
+     * times are extrapolated from it. Only the `_shortlist` candidates with the best estimated
+     * makespan are evaluated exactly.
+     */
+    template <typename ST, std::size_t L>
+    class CrossExchange : public TabuPairNeighborhood<ST>
+    {
+    private:
+        static_assert(L > 0);
+
+        /** @brief The number of screened candidates evaluated exactly */
+        static constexpr std::size_t _shortlist = 16;
+
+        /** @brief Segment aggregates of a route */
+        struct _Route
+        {
+            bool drone;
+            std::size_t vehicle, trip;
+            const std::vector<std::size_t> *customers;
+            double working_time, distance, capacity;
+
+            /** @brief Working time per unit of distance, to extrapolate the working time of the modified route */
+            double rate;
+
+            /** @brief Prefix sums of distances traveled forward and backward, `forward[i]` is the distance from `customers[0]` to `customers[i]` */
+            std::vector<double> forward, backward;
+
+            /** @brief Prefix sums of demands */
+            std::vector<double> demands;
+
+            /** @brief Prefix counts of customers that drones cannot serve */
+            std::vector<std::size_t> non_dronable;
+        };
+
+        struct _Candidate
+        {
+            std::pair<double, double> key;
+            std::size_t route_a, a, length_a, route_b, b, length_b;
+            bool reverse_a, reverse_b;
+
+            bool operator<(const _Candidate &other) const
+            {
+                return key < other.key;
+            }
+        };
+
+        _Route _aggregate(const bool &drone, const std::size_t &vehicle, const std::size_t &trip, const _BaseRoute &route) const
+        {
+            auto problem = this->problem;
+            auto &customers = route.customers();
+
+            _Route result{
+                drone, vehicle, trip, &customers, route.working_time(), route.distance(),
+                drone ? problem->drone->capacity : problem->truck->capacity,
+                route.working_time() / std::max(route.distance(), 1e-9),
+                {0}, {0}, {0}, {0}};
+            for (std::size_t i = 0; i + 1 < customers.size(); i++)
+            {
+                result.forward.push_back(result.forward.back() + problem->distances[customers[i]][customers[i + 1]]);
+                result.backward.push_back(result.backward.back() + problem->distances[customers[i + 1]][customers[i]]);
+            }
+
+            for (auto &customer : customers)
+            {
+                result.demands.push_back(result.demands.back() + problem->customer_arrays.demand[customer]);
+                result.non_dronable.push_back(result.non_dronable.back() + !problem->customer_arrays.dronable[customer]);
+            }
+
+            return result;
+        }
+
+        /**
+         * @brief The distance of `to` after replacing its segment `[t, t + length_to)` by the segment
+         * `[f, f + length_from)` of `from`, reversed if `reverse`.
+         */
+        double _replaced_distance(
+            const _Route &to, const std::size_t &t, const std::size_t &length_to,
+            const _Route &from, const std::size_t &f, const std::size_t &length_from, const bool &reverse) const
+        {
+            auto &distances = this->problem->distances;
+            auto &c = *to.customers;
+            auto before = c[t - 1], after = c[t + length_to];
+
+            double result = to.distance - (to.forward[t + length_to] - to.forward[t - 1]);
+            if (length_from == 0)
+            {
+                return result + distances[before][after];
+            }
+
+            auto &s = *from.customers;
+            auto first = s[f], last = s[f + length_from - 1];
+            double inner = from.forward[f + length_from - 1] - from.forward[f];
+            if (reverse)
+            {
+                std::swap(first, last);
+                inner = from.backward[f + length_from - 1] - from.backward[f];
+            }
+
+            return result + distances[before][first] + inner + distances[last][after];
+        }
+
+        /** @brief The customers of `to` after the same replacement as `_replaced_distance`. */
+        static std::vector<std::size_t> _replaced_customers(
+            const _Route &to, const std::size_t &t, const std::size_t &length_to,
+            const _Route &from, const std::size_t &f, const std::size_t &length_from, const bool &reverse)
+        {
+            auto &c = *to.customers, &s = *from.customers;
+            std::vector<std::size_t> result(c.begin(), c.begin() + t);
+            if (reverse)
+            {
+                result.insert(result.end(), std::make_reverse_iterator(s.begin() + (f + length_from)), std::make_reverse_iterator(s.begin() + f));
+            }
+            else
+            {
+                result.insert(result.end(), s.begin() + f, s.begin() + (f + length_from));
+            }
+
+            result.insert(result.end(), c.begin() + (t + length_to), c.end());
+            return result;
+        }
+
+    public:
+        CrossExchange(const Problem *problem) : TabuPairNeighborhood<ST>(problem) {}
+
+        template <typename _AspirationCriteria>
+        std::shared_ptr<ST> move(
+            const std::shared_ptr<ST> &solution,
+            const _AspirationCriteria &aspiration_criteria)
+        {
+            auto problem = this->problem;
+            std::shared_ptr<ST> result;
+            std::pair<std::size_t, std::size_t> tabu_pair;
+
+            // Vehicles are indexed trucks first, then drones
+            std::vector<_Route> routes;
+            std::vector<double> loads(problem->trucks_count + problem->drones_count);
+            for (std::size_t vehicle = 0; vehicle < problem->trucks_count; vehicle++)
+            {
+                for (std::size_t trip = 0; trip < solution->truck_routes[vehicle].size(); trip++)
+                {
+                    routes.push_back(_aggregate(false, vehicle, trip, solution->truck_routes[vehicle][trip]));
+                    loads[vehicle] += routes.back().working_time;
+                }
+            }
+
+            for (std::size_t vehicle = 0; vehicle < problem->drones_count; vehicle++)
+            {
+                for (std::size_t trip = 0; trip < solution->drone_routes[vehicle].size(); trip++)
+                {
+                    routes.push_back(_aggregate(true, vehicle, trip, solution->drone_routes[vehicle][trip]));
+                    loads[problem->trucks_count + vehicle] += routes.back().working_time;
+                }
+            }
+
+            const auto vehicle_of = [&problem](const _Route &route)
+            {
+                return route.drone ? problem->trucks_count + route.vehicle : route.vehicle;
+            };
+
+            // The 3 most loaded vehicles, so that the maximum load of the vehicles not involved in a move is known
+            std::vector<std::size_t> top(loads.size());
+            std::iota(top.begin(), top.end(), 0);
+            std::partial_sort(
+                top.begin(), top.begin() + std::min<std::size_t>(3, top.size()), top.end(),
+                [&loads](const std::size_t &first, const std::size_t &second)
+                {
+                    return loads[first] > loads[second];
+                });
+            top.resize(std::min<std::size_t>(3, top.size()));
+
+            // Max-heap of the best candidates so far, by estimated (makespan, working time increase)
+            std::priority_queue<_Candidate> shortlist;
+            for (std::size_t route_a = 0; route_a < routes.size(); route_a++)
+            {
+                for (std::size_t route_b = route_a + 1; route_b < routes.size(); route_b++)
+                {
+                    auto &ra = routes[route_a], &rb = routes[route_b];
+                    auto vehicle_a = vehicle_of(ra), vehicle_b = vehicle_of(rb);
+
+                    double others = 0;
+                    for (auto &vehicle : top)
+                    {
+                        if (vehicle != vehicle_a && vehicle != vehicle_b)
+                        {
+                            others = loads[vehicle];
+                            break;
+                        }
+                    }
+
+                    // Customers are at indices [1, size - 2], an empty segment at `a` is the position before customers[a]
+                    std::size_t size_a = ra.customers->size(), size_b = rb.customers->size();
+                    for (std::size_t a = 1; a + 1 < size_a; a++)
+                    {
+                        for (std::size_t length_a = 0; length_a <= L && a + length_a + 1 <= size_a; length_a++)
+                        {
+                            double weight_a = ra.demands[a + length_a] - ra.demands[a];
+                            bool dronable_a = ra.non_dronable[a + length_a] == ra.non_dronable[a];
+                            if (rb.drone && !dronable_a)
+                            {
+                                break;
+                            }
+
+                            for (std::size_t b = 1; b + 1 < size_b; b++)
+                            {
+                                for (std::size_t length_b = length_a == 0 ? 1 : 0; length_b <= L && b + length_b + 1 <= size_b; length_b++)
+                                {
+                                    double weight_b = rb.demands[b + length_b] - rb.demands[b];
+                                    bool dronable_b = rb.non_dronable[b + length_b] == rb.non_dronable[b];
+                                    if (ra.drone && !dronable_b)
+                                    {
+                                        break;
+                                    }
+
+                                    // Do not worsen capacity violations
+                                    double new_weight_a = ra.demands.back() - weight_a + weight_b,
+                                           new_weight_b = rb.demands.back() - weight_b + weight_a;
+                                    if ((new_weight_a > ra.capacity && weight_b > weight_a) ||
+                                        (new_weight_b > rb.capacity && weight_a > weight_b))
+                                    {
+                                        continue;
+                                    }
+
+                                    for (int reverse_b = 0; reverse_b <= (length_b > 1); reverse_b++)
+                                    {
+                                        double time_a = size_a - length_a + length_b == 2
+                                                            ? 0.0
+                                                            : ra.working_time + ra.rate * (_replaced_distance(ra, a, length_a, rb, b, length_b, reverse_b) - ra.distance);
+
+                                        for (int reverse_a = 0; reverse_a <= (length_a > 1); reverse_a++)
+                                        {
+                                            double time_b = size_b - length_b + length_a == 2
+                                                                ? 0.0
+                                                                : rb.working_time + rb.rate * (_replaced_distance(rb, b, length_b, ra, a, length_a, reverse_a) - rb.distance);
+
+                                            double delta_a = time_a - ra.working_time, delta_b = time_b - rb.working_time, makespan = others;
+                                            if (vehicle_a == vehicle_b)
+                                            {
+                                                makespan = std::max(makespan, loads[vehicle_a] + delta_a + delta_b);
+                                            }
+                                            else
+                                            {
+                                                makespan = std::max({makespan, loads[vehicle_a] + delta_a, loads[vehicle_b] + delta_b});
+                                            }
+
+                                            _Candidate candidate{
+                                                std::make_pair(makespan, delta_a + delta_b),
+                                                route_a, a, length_a, route_b, b, length_b, reverse_a == 1, reverse_b == 1};
+                                            if (shortlist.size() < _shortlist)
+                                            {
+                                                shortlist.push(candidate);
+                                            }
+                                            else if (candidate < shortlist.top())
+                                            {
+                                                shortlist.pop();
+                                                shortlist.push(candidate);
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (; !shortlist.empty(); shortlist.pop())
+            {
+                auto &candidate = shortlist.top();
+                auto &ra = routes[candidate.route_a], &rb = routes[candidate.route_b];
+                auto customers_a = _replaced_customers(ra, candidate.a, candidate.length_a, rb, candidate.b, candidate.length_b, candidate.reverse_b),
+                     customers_b = _replaced_customers(rb, candidate.b, candidate.length_b, ra, candidate.a, candidate.length_a, candidate.reverse_a);
+
+#ifdef DEBUG
+                for (auto [customers, distance] : {
+                         std::make_pair(&customers_a, _replaced_distance(ra, candidate.a, candidate.length_a, rb, candidate.b, candidate.length_b, candidate.reverse_b)),
+                         std::make_pair(&customers_b, _replaced_distance(rb, candidate.b, candidate.length_b, ra, candidate.a, candidate.length_a, candidate.reverse_a))})
+                {
+                    double expected = 0;
+                    for (std::size_t i = 0; i + 1 < customers->size(); i++)
+                    {
+                        expected += problem->distances[(*customers)[i]][(*customers)[i + 1]];
+                    }
+
+                    if (!utils::approximate(distance, expected))
+                    {
+                        throw std::runtime_error(utils::format("Inconsistent segment aggregates: distance %lf, expected %lf", distance, expected));
+                    }
+                }
+#endif
+
+                std::vector<std::vector<TruckRoute>> truck_routes(solution->truck_routes);
+                std::vector<std::vector<DroneRoute>> drone_routes(solution->drone_routes);
+
+                // Replace `rb` first: when both routes belong to the same vehicle, `rb` is the later trip,
+                // so erasing it does not shift `ra`
+                for (auto [route, customers] : {std::make_pair(&rb, &customers_b), std::make_pair(&ra, &customers_a)})
+                {
+#define REPLACE_ROUTE(vehicle_routes, RouteT)                 \
+    {                                                         \
+        auto &trips = vehicle_routes[route->vehicle];         \
+        if (customers->size() == 2)                           \
+        {                                                     \
+            trips.erase(trips.begin() + route->trip);         \
+        }                                                     \
+        else                                                  \
+        {                                                     \
+            trips[route->trip] = RouteT(problem, *customers); \
+        }                                                     \
+    }
+
+                    if (route->drone)
+                    {
+                        REPLACE_ROUTE(drone_routes, DroneRoute);
+                    }
+                    else
+                    {
+                        REPLACE_ROUTE(truck_routes, TruckRoute);
+                    }
+
+#undef REPLACE_ROUTE
+                }
+
+                auto &c_a = *ra.customers, &c_b = *rb.customers;
+                auto first = c_a[candidate.a], second = c_b[candidate.b];
+
+                auto new_solution = std::make_shared<ST>(problem, truck_routes, drone_routes);
+                if (this->is_admissible(*new_solution, first, second, aspiration_criteria) &&
+                    (result == nullptr || new_solution->cost() < result->cost()))
+                {
+                    result.swap(new_solution);
+                    tabu_pair = std::make_pair(first, second);
+                }
+            }
+
+            this->add_to_tabu(tabu_pair.first, tabu_pair.second);
+
+            return result;
+        }
+
+        static std::string label()
+        {
+            return utils::format("CROSS(%lu)", L);
+        }
+    };
+}
@@ -5,24 +5,30 @@
 namespace d2d
 {
     template <typename ST, int X, int Y>
-    class MoveXY : public CommonRouteNeighborhood<ST>
+    class MoveXY : public CommonRouteNeighborhood<ST, MoveXY<ST, X, Y>>
     {
     private:
+        friend class CommonRouteNeighborhood<ST, MoveXY<ST, X, Y>>;
+
+        template <typename _AspirationCriteria>
         std::pair<std::shared_ptr<ST>, std::pair<std::size_t, std::size_t>> same_route(
             const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria) override
+            const _AspirationCriteria &aspiration_criteria)
         {
-            auto problem = Problem::get_instance();
+            auto problem = this->problem;
             std::shared_ptr<ST> result;
             std::pair<std::size_t, std::size_t> tabu_pair;
 
             std::vector<std::vector<TruckRoute>> truck_routes(solution->truck_routes);
             std::vector<std::vector<DroneRoute>> drone_routes(solution->drone_routes);
+            auto working_times = this->vehicle_working_times(*solution);
 
-#define MODIFY_ROUTES(vehicles_count, vehicle_routes, X, Y)                                                                           \
+#define MODIFY_ROUTES(vehicles_offset, vehicles_count, vehicle_routes, X, Y)                                                          \
     {                                                                                                                                 \
         for (std::size_t index = 0; index < problem->vehicles_count; index++)                                                         \
         {                                                                                                                             \
+            const std::size_t vehicle = vehicles_offset + index;                                                                      \
+            const double working_time = working_times.get(vehicle);                                                                   \
             for (std::size_t route = 0; route < vehicle_routes[index].size(); route++)                                                \
             {                                                                                                                         \
                 const std::vector<std::size_t> &customers = solution->vehicle_routes[index][route].customers();                       \
@@ -44,30 +50,36 @@ namespace d2d
                         }                                                                                                             \
                                                                                                                                       \
                         using VehicleRoute = std::remove_reference_t<decltype(vehicle_routes[index][route])>;                         \
-                        vehicle_routes[index][route] = VehicleRoute(new_customers);                                                   \
+                        vehicle_routes[index][route] = VehicleRoute(problem, new_customers);                                          \
+                        working_times.set(vehicle, this->vehicle_working_time(vehicle_routes[index]));                                \
                                                                                                                                       \
-                        auto new_solution = std::make_shared<ST>(truck_routes, drone_routes);                                         \
-                        if ((aspiration_criteria(*new_solution) || !this->is_tabu(customers[i], customers[j])) &&                     \
-                            (result == nullptr || new_solution->cost() < result->cost()))                                             \
+                        if (this->may_improve(result, working_times))                                                                 \
                         {                                                                                                             \
-                            result.swap(new_solution);                                                                                \
-                            tabu_pair = std::make_pair(customers[i], customers[j]);                                                   \
+                            auto new_solution = std::make_shared<ST>(problem, truck_routes, drone_routes);                            \
+                            this->check_working_times(*new_solution, working_times);                                                  \
+                            if (this->is_admissible(*new_solution, customers[i], customers[j], aspiration_criteria) &&                \
+                                (result == nullptr || new_solution->cost() < result->cost()))                                         \
+                            {                                                                                                         \
+                                result.swap(new_solution);                                                                            \
+                                tabu_pair = std::make_pair(customers[i], customers[j]);                                               \
+                            }                                                                                                         \
                         }                                                                                                             \
                                                                                                                                       \
                         /* Restore */                                                                                                 \
                         vehicle_routes[index][route] = solution->vehicle_routes[index][route];                                        \
+                        working_times.set(vehicle, working_time);                                                                     \
                     }                                                                                                                 \
                 }                                                                                                                     \
             }                                                                                                                         \
         }                                                                                                                             \
     }
 
-            MODIFY_ROUTES(trucks_count, truck_routes, X, Y);
-            MODIFY_ROUTES(drones_count, drone_routes, X, Y);
+            MODIFY_ROUTES(0, trucks_count, truck_routes, X, Y);
+            MODIFY_ROUTES(problem->trucks_count, drones_count, drone_routes, X, Y);
             if constexpr (X != Y)
             {
-                MODIFY_ROUTES(trucks_count, truck_routes, Y, X);
-                MODIFY_ROUTES(drones_count, drone_routes, Y, X);
+                MODIFY_ROUTES(0, trucks_count, truck_routes, Y, X);
+                MODIFY_ROUTES(problem->trucks_count, drones_count, drone_routes, Y, X);
             }
 
 #undef MODIFY_ROUTES
@@ -75,16 +87,18 @@ namespace d2d
             return std::make_pair(result, tabu_pair);
         }
 
+        template <typename _AspirationCriteria>
         std::pair<std::shared_ptr<ST>, std::pair<std::size_t, std::size_t>> multi_route(
             const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria) override
+            const _AspirationCriteria &aspiration_criteria)
         {
-            auto problem = Problem::get_instance();
+            auto problem = this->problem;
             std::shared_ptr<ST> result;
             std::pair<std::size_t, std::size_t> tabu_pair;
 
             std::vector<std::vector<TruckRoute>> truck_routes(solution->truck_routes);
             std::vector<std::vector<DroneRoute>> drone_routes(solution->drone_routes);
+            auto working_times = this->vehicle_working_times(*solution);
             for (std::size_t vehicle_i = 0; vehicle_i < problem->trucks_count + problem->drones_count; vehicle_i++)
             {
                 std::size_t offset_j = 0;
@@ -99,6 +113,7 @@ namespace d2d
     {                                                                                                                                                             \
         std::size_t _vehicle_i = vehicle_i < problem->trucks_count ? vehicle_i : vehicle_i - problem->trucks_count,                                               \
                     _vehicle_j = vehicle_j < problem->trucks_count ? vehicle_j : vehicle_j - problem->trucks_count;                                               \
+        const double working_time_i = working_times.get(vehicle_i), working_time_j = working_times.get(vehicle_j);                                                \
         for (std::size_t route_i = 0; route_i < solution->vehicle_routes_i[_vehicle_i].size(); route_i++)                                                         \
         {                                                                                                                                                         \
             for (std::size_t route_j = 0; route_j < solution->vehicle_routes_j[_vehicle_j].size(); route_j++)                                                     \
@@ -130,7 +145,7 @@ namespace d2d
                                                                                                                                                                   \
                         if constexpr (std::is_same_v<VehicleRoute_i, DroneRoute>)                                                                                 \
                         {                                                                                                                                         \
-                            if (std::any_of(ri.begin(), ri.end(), [&problem](const std::size_t &c) { return !problem->customers[c].dronable; }))                  \
+                            if (std::any_of(ri.begin(), ri.end(), [&problem](const std::size_t &c) { return !problem->customer_arrays.dronable[c]; }))            \
                             {                                                                                                                                     \
                                 continue;                                                                                                                         \
                             }                                                                                                                                     \
@@ -138,7 +153,7 @@ namespace d2d
                                                                                                                                                                   \
                         if constexpr (std::is_same_v<VehicleRoute_j, DroneRoute>)                                                                                 \
                         {                                                                                                                                         \
-                            if (std::any_of(rj.begin(), rj.end(), [&problem](const std::size_t &c) { return !problem->customers[c].dronable; }))                  \
+                            if (std::any_of(rj.begin(), rj.end(), [&problem](const std::size_t &c) { return !problem->customer_arrays.dronable[c]; }))            \
                             {                                                                                                                                     \
                                 continue;                                                                                                                         \
                             }                                                                                                                                     \
@@ -151,7 +166,7 @@ namespace d2d
                         }                                                                                                                                         \
                         else                                                                                                                                      \
                         {                                                                                                                                         \
-                            vehicle_routes_i[_vehicle_i][route_i] = VehicleRoute_i(ri);                                                                           \
+                            vehicle_routes_i[_vehicle_i][route_i] = VehicleRoute_i(problem, ri);                                                                  \
                         }                                                                                                                                         \
                                                                                                                                                                   \
                         if (rj_empty)                                                                                                                             \
@@ -160,15 +175,22 @@ namespace d2d
                         }                                                                                                                                         \
                         else                                                                                                                                      \
                         {                                                                                                                                         \
-                            vehicle_routes_j[_vehicle_j][route_j] = VehicleRoute_j(rj);                                                                           \
+                            vehicle_routes_j[_vehicle_j][route_j] = VehicleRoute_j(problem, rj);                                                                  \
                         }                                                                                                                                         \
                                                                                                                                                                   \
-                        auto new_solution = std::make_shared<ST>(truck_routes, drone_routes);                                                                     \
-                        if ((aspiration_criteria(*new_solution) || !this->is_tabu(customers_i[i], customers_j[j])) &&                                             \
-                            (result == nullptr || new_solution->cost() < result->cost()))                                                                         \
+                        working_times.set(vehicle_i, this->vehicle_working_time(vehicle_routes_i[_vehicle_i]));                                                   \
+                        working_times.set(vehicle_j, this->vehicle_working_time(vehicle_routes_j[_vehicle_j]));                                                   \
+                                                                                                                                                                  \
+                        if (this->may_improve(result, working_times))                                                                                             \
                         {                                                                                                                                         \
-                            result.swap(new_solution);                                                                                                            \
-                            tabu_pair = std::make_pair(customers_i[i], customers_j[j]);                                                                           \
+                            auto new_solution = std::make_shared<ST>(problem, truck_routes, drone_routes);                                                        \
+                            this->check_working_times(*new_solution, working_times);                                                                              \
+                            if (this->is_admissible(*new_solution, customers_i[i], customers_j[j], aspiration_criteria) &&                                        \
+                                (result == nullptr || new_solution->cost() < result->cost()))                                                                     \
+                            {                                                                                                                                     \
+                                result.swap(new_solution);                                                                                                        \
+                                tabu_pair = std::make_pair(customers_i[i], customers_j[j]);                                                                       \
+                            }                                                                                                                                     \
                         }                                                                                                                                         \
                                                                                                                                                                   \
                         /* Restore */                                                                                                                             \
@@ -189,6 +211,9 @@ namespace d2d
                         {                                                                                                                                         \
                             vehicle_routes_j[_vehicle_j][route_j] = solution->vehicle_routes_j[_vehicle_j][route_j];                                              \
                         }                                                                                                                                         \
+                                                                                                                                                                  \
+                        working_times.set(vehicle_i, working_time_i);                                                                                             \
+                        working_times.set(vehicle_j, working_time_j);                                                                                             \
                     }                                                                                                                                             \
                 }                                                                                                                                                 \
             }                                                                                                                                                     \
@@ -208,7 +233,14 @@ namespace d2d
                     }
                     else
                     {
-                        MODIFY_ROUTES(drone_routes, drone_routes);
+                        if (vehicle_j < problem->trucks_count) // only reachable when X != Y
+                        {
+                            MODIFY_ROUTES(drone_routes, truck_routes);
+                        }
+                        else
+                        {
+                            MODIFY_ROUTES(drone_routes, drone_routes);
+                        }
                     }
 
 #undef MODIFY_ROUTES
@@ -217,14 +249,31 @@ namespace d2d
 
             return std::make_pair(result, tabu_pair);
         }
+
+    public:
+        MoveXY(const Problem *problem) : CommonRouteNeighborhood<ST, MoveXY<ST, X, Y>>(problem) {}
+
+        static std::string label()
+        {
+            return utils::format("Move(%d, %d)", X, Y);
+        }
     };
 
     template <typename ST, int X>
-    class MoveXY<ST, X, 0> : public CommonRouteNeighborhood<ST>
+    class MoveXY<ST, X, 0> : public CommonRouteNeighborhood<ST, MoveXY<ST, X, 0>>
     {
+    public:
+        MoveXY(const Problem *problem) : CommonRouteNeighborhood<ST, MoveXY<ST, X, 0>>(problem) {}
+
+        static std::string label()
+        {
+            return utils::format("Move(%d, 0)", X);
+        }
+
+        template <typename _AspirationCriteria>
         std::shared_ptr<ST> move(
             const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria)
+            const _AspirationCriteria &aspiration_criteria)
         {
         }
     };
@@ -232,9 +281,18 @@ namespace d2d
     template <typename ST>
     class MoveXY<ST, 0, 0> : public TabuPairNeighborhood<ST>
     {
+    public:
+        MoveXY(const Problem *problem) : TabuPairNeighborhood<ST>(problem) {}
+
+        static std::string label()
+        {
+            return "Move(0, 0)";
+        }
+
+        template <typename _AspirationCriteria>
         std::shared_ptr<ST> move(
             const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria)
+            const _AspirationCriteria &aspiration_criteria)
         {
             return nullptr;
         }
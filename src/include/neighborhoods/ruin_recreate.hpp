@@ -0,0 +1,382 @@
+#pragma once
+
+#include "abc.hpp"
+#include "../initial.hpp"
+#include "../random.hpp"
+#include "../routes.hpp"
+
+namespace d2d
+{
+    /**
+     * @brief Large neighborhood search: remove a set of related customers, then reinsert them.
+     *
+     * Each call samples a few ruins, removing customers at random, around a random seed customer
+     * (radial) or where their detours are the largest (worst cost). Removed customers are then
+     * reinserted one at a time, each time with the move increasing the makespan the least and then
+     * the working time the least. The cheapest insertion of every removed customer into every trip
+     * is cached, so that an insertion only recalculates the entries of the trip it modifies.
+     *
+     * The tabu pair of a move is the first and the last customer removed.
+     */
+    template <typename ST>
+    class RuinRecreate : public TabuPairNeighborhood<ST>
+    {
+    private:
+        /** @brief The number of ruins sampled per move */
+        static constexpr std::size_t _attempts = 4;
+
+        /** @brief A trip of a vehicle, or a new trip if `trip` is the number of its trips */
+        struct _Slot
+        {
+            bool drone;
+            std::size_t vehicle;
+            std::size_t trip;
+        };
+
+        /** @brief The cheapest feasible insertion of a customer into a slot */
+        struct _Insertion
+        {
+            /** @brief Increase of working time, infinite if infeasible */
+            double delta;
+
+            /** @brief Index in the trip to insert the customer at */
+            std::size_t position;
+        };
+
+        std::vector<std::size_t> _ruin(const ST &solution) const
+        {
+            auto problem = this->problem;
+            const std::size_t n = problem->customers.size() - 1;
+            auto count = utils::random<std::size_t>(std::min<std::size_t>(n, 3), std::clamp<std::size_t>(n / 8, std::min<std::size_t>(n, 3), 30));
+
+            std::vector<std::size_t> customers(n);
+            std::iota(customers.begin(), customers.end(), 1);
+
+            switch (utils::random<int>(0, 2))
+            {
+            case 0: // Random
+                std::shuffle(customers.begin(), customers.end(), utils::rng);
+                break;
+
+            case 1: // Radial
+            {
+                auto seed = utils::random_element(customers);
+                std::sort(
+                    customers.begin(), customers.end(),
+                    [&problem, &seed](const std::size_t &first, const std::size_t &second)
+                    {
+                        return problem->distances[seed][first] < problem->distances[seed][second];
+                    });
+                break;
+            }
+
+            default: // Worst cost, with noise so that repeated ruins differ
+            {
+                std::vector<double> gains(n + 1);
+#define DETOURS(vehicle_routes)                                                                                              \
+    for (auto &routes : vehicle_routes)                                                                                      \
+    {                                                                                                                        \
+        for (auto &route : routes)                                                                                           \
+        {                                                                                                                    \
+            auto &c = route.customers();                                                                                     \
+            for (std::size_t i = 1; i + 1 < c.size(); i++)                                                                   \
+            {                                                                                                                \
+                auto detour = problem->distances[c[i - 1]][c[i]] + problem->distances[c[i]][c[i + 1]] -                      \
+                              problem->distances[c[i - 1]][c[i + 1]];                                                        \
+                gains[c[i]] = detour * utils::random(0.5, 1.0);                                                              \
+            }                                                                                                                \
+        }                                                                                                                    \
+    }
+
+                DETOURS(solution.truck_routes);
+                DETOURS(solution.drone_routes);
+#undef DETOURS
+
+                std::sort(
+                    customers.begin(), customers.end(),
+                    [&gains](const std::size_t &first, const std::size_t &second)
+                    {
+                        return gains[first] > gains[second];
+                    });
+                break;
+            }
+            }
+
+            customers.resize(count);
+            return customers;
+        }
+
+        std::shared_ptr<ST> _recreate(const ST &solution, const std::vector<std::size_t> &removed) const
+        {
+            auto problem = this->problem;
+            const double infinity = std::numeric_limits<double>::infinity();
+
+            std::vector<bool> is_removed(problem->customers.size());
+            for (auto &customer : removed)
+            {
+                is_removed[customer] = true;
+            }
+
+            std::vector<std::vector<std::vector<std::size_t>>> truck_trips(problem->trucks_count), drone_trips(problem->drones_count);
+            std::vector<std::vector<double>> truck_times(problem->trucks_count), drone_times(problem->drones_count);
+            std::vector<double> truck_loads(problem->trucks_count), drone_loads(problem->drones_count);
+
+#define RUIN_ROUTES(vehicle_routes, trips, times, loads, RouteT)                                   \
+    for (std::size_t vehicle = 0; vehicle < vehicle_routes.size(); vehicle++)                     \
+    {                                                                                              \
+        for (auto &route : vehicle_routes[vehicle])                                                \
+        {                                                                                          \
+            std::vector<std::size_t> customers;                                                    \
+            for (auto &customer : route.customers())                                               \
+            {                                                                                      \
+                if (!is_removed[customer])                                                         \
+                {                                                                                  \
+                    customers.push_back(customer);                                                 \
+                }                                                                                  \
+            }                                                                                      \
+                                                                                                   \
+            if (customers.size() > 2)                                                              \
+            {                                                                                      \
+                auto time = customers.size() == route.customers().size()                           \
+                                ? route.working_time()                                             \
+                                : RouteT(problem, customers).working_time();                       \
+                trips[vehicle].push_back(std::move(customers));                                    \
+                times[vehicle].push_back(time);                                                    \
+                loads[vehicle] += time;                                                            \
+            }                                                                                      \
+        }                                                                                          \
+    }
+
+            RUIN_ROUTES(solution.truck_routes, truck_trips, truck_times, truck_loads, TruckRoute);
+            RUIN_ROUTES(solution.drone_routes, drone_trips, drone_times, drone_loads, DroneRoute);
+#undef RUIN_ROUTES
+
+            std::vector<_Slot> slots;
+            for (std::size_t vehicle = 0; vehicle < problem->trucks_count; vehicle++)
+            {
+                for (std::size_t trip = 0; trip <= truck_trips[vehicle].size(); trip++)
+                {
+                    slots.push_back(_Slot{false, vehicle, trip});
+                }
+            }
+
+            for (std::size_t vehicle = 0; vehicle < problem->drones_count; vehicle++)
+            {
+                for (std::size_t trip = 0; trip <= drone_trips[vehicle].size(); trip++)
+                {
+                    slots.push_back(_Slot{true, vehicle, trip});
+                }
+            }
+
+            std::vector<std::size_t> buffer;
+            const auto insertion = [&](const std::size_t &customer, const _Slot &slot)
+            {
+                _Insertion result{infinity, 0};
+                if (slot.drone && !problem->customer_arrays.dronable[customer])
+                {
+                    return result;
+                }
+
+                auto &trips = slot.drone ? drone_trips[slot.vehicle] : truck_trips[slot.vehicle];
+                if (slot.trip == trips.size())
+                {
+                    buffer.assign({0, customer, 0});
+                    if (slot.drone)
+                    {
+                        DroneRoute route(problem, buffer);
+                        result.delta = _feasible(route) ? route.working_time() : infinity;
+                    }
+                    else
+                    {
+                        // Always allowed, so that every customer can be reinserted
+                        result.delta = TruckRoute(problem, buffer).working_time();
+                    }
+
+                    return result;
+                }
+
+                auto &customers = trips[slot.trip];
+                auto time = (slot.drone ? drone_times : truck_times)[slot.vehicle][slot.trip];
+                for (std::size_t position = 1; position < customers.size(); position++)
+                {
+                    buffer.assign(customers.begin(), customers.end());
+                    buffer.insert(buffer.begin() + position, customer);
+
+                    double delta = infinity;
+                    if (slot.drone)
+                    {
+                        DroneRoute route(problem, buffer);
+                        delta = _feasible(route) ? route.working_time() - time : infinity;
+                    }
+                    else
+                    {
+                        TruckRoute route(problem, buffer);
+                        delta = _feasible(route) ? route.working_time() - time : infinity;
+                    }
+
+                    if (delta < result.delta)
+                    {
+                        result = _Insertion{delta, position};
+                    }
+                }
+
+                return result;
+            };
+
+            // table[i][s] is the cheapest insertion of removed[i] into slots[s]
+            std::vector<std::vector<_Insertion>> table(removed.size());
+            for (std::size_t i = 0; i < removed.size(); i++)
+            {
+                for (auto &slot : slots)
+                {
+                    table[i].push_back(insertion(removed[i], slot));
+                }
+            }
+
+            std::vector<bool> inserted(removed.size());
+            for (std::size_t step = 0; step < removed.size(); step++)
+            {
+                double makespan = 0;
+                for (auto &load : truck_loads)
+                {
+                    makespan = std::max(makespan, load);
+                }
+
+                for (auto &load : drone_loads)
+                {
+                    makespan = std::max(makespan, load);
+                }
+
+                std::size_t best_i = removed.size(), best_s = 0;
+                std::pair<double, double> best_key(infinity, infinity);
+                for (std::size_t i = 0; i < removed.size(); i++)
+                {
+                    if (inserted[i])
+                    {
+                        continue;
+                    }
+
+                    for (std::size_t s = 0; s < slots.size(); s++)
+                    {
+                        auto &entry = table[i][s];
+                        if (std::isinf(entry.delta))
+                        {
+                            continue;
+                        }
+
+                        auto load = (slots[s].drone ? drone_loads : truck_loads)[slots[s].vehicle];
+                        std::pair<double, double> key(std::max(makespan, load + entry.delta), entry.delta);
+                        if (key < best_key)
+                        {
+                            best_key = key;
+                            best_i = i;
+                            best_s = s;
+                        }
+                    }
+                }
+
+                if (best_i == removed.size())
+                {
+                    return nullptr; // No feasible reinsertion, e.g. a dronable customer without trucks
+                }
+
+                inserted[best_i] = true;
+                auto slot = slots[best_s];
+                auto &trips = slot.drone ? drone_trips[slot.vehicle] : truck_trips[slot.vehicle];
+                auto &times = slot.drone ? drone_times[slot.vehicle] : truck_times[slot.vehicle];
+                (slot.drone ? drone_loads : truck_loads)[slot.vehicle] += table[best_i][best_s].delta;
+
+                std::vector<std::size_t> modified{best_s};
+                if (slot.trip == trips.size())
+                {
+                    trips.push_back({0, removed[best_i], 0});
+                    times.push_back(table[best_i][best_s].delta);
+
+                    // The slot now refers to the new trip, append another slot for opening a trip
+                    slots.push_back(_Slot{slot.drone, slot.vehicle, trips.size()});
+                    modified.push_back(slots.size() - 1);
+                    for (std::size_t i = 0; i < removed.size(); i++)
+                    {
+                        table[i].push_back(_Insertion{infinity, 0});
+                    }
+                }
+                else
+                {
+                    auto &customers = trips[slot.trip];
+                    customers.insert(customers.begin() + table[best_i][best_s].position, removed[best_i]);
+                    times[slot.trip] += table[best_i][best_s].delta;
+                }
+
+                // Only insertions into the modified trip (and the new trip slot) change
+                for (std::size_t i = 0; i < removed.size(); i++)
+                {
+                    if (!inserted[i])
+                    {
+                        for (auto &s : modified)
+                        {
+                            table[i][s] = insertion(removed[i], slots[s]);
+                        }
+                    }
+                }
+            }
+
+            std::vector<std::vector<TruckRoute>> truck_routes(problem->trucks_count);
+            std::vector<std::vector<DroneRoute>> drone_routes(problem->drones_count);
+            for (std::size_t vehicle = 0; vehicle < problem->trucks_count; vehicle++)
+            {
+                for (auto &customers : truck_trips[vehicle])
+                {
+                    truck_routes[vehicle].emplace_back(problem, customers);
+                }
+            }
+
+            for (std::size_t vehicle = 0; vehicle < problem->drones_count; vehicle++)
+            {
+                for (auto &customers : drone_trips[vehicle])
+                {
+                    drone_routes[vehicle].emplace_back(problem, customers);
+                }
+            }
+
+            return std::make_shared<ST>(problem, truck_routes, drone_routes);
+        }
+
+    public:
+        RuinRecreate(const Problem *problem) : TabuPairNeighborhood<ST>(problem) {}
+
+        template <typename _AspirationCriteria>
+        std::shared_ptr<ST> move(
+            const std::shared_ptr<ST> &solution,
+            const _AspirationCriteria &aspiration_criteria)
+        {
+            std::shared_ptr<ST> result;
+            std::pair<std::size_t, std::size_t> tabu_pair;
+            if (this->problem->customers.size() < 3)
+            {
+                return result;
+            }
+
+            for (std::size_t attempt = 0; attempt < _attempts; attempt++)
+            {
+                auto removed = _ruin(*solution);
+                auto candidate = _recreate(*solution, removed);
+                if (candidate != nullptr &&
+                    this->is_admissible(*candidate, removed.front(), removed.back(), aspiration_criteria) &&
+                    (result == nullptr || candidate->cost() < result->cost()))
+                {
+                    result = candidate;
+                    tabu_pair = std::make_pair(removed.front(), removed.back());
+                }
+            }
+
+            this->add_to_tabu(tabu_pair.first, tabu_pair.second);
+
+            return result;
+        }
+
+        static std::string label()
+        {
+            return "RuinRecreate";
+        }
+    };
+}
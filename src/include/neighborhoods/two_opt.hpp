@@ -1,72 +1,274 @@
 #pragma once
 
 #include "abc.hpp"
+#include "../simd.hpp"
 
 namespace d2d
 {
     template <typename ST>
-    class TwoOpt : public CommonRouteNeighborhood<ST>
+    class TwoOpt : public CommonRouteNeighborhood<ST, TwoOpt<ST>>
     {
     private:
+        friend class CommonRouteNeighborhood<ST, TwoOpt<ST>>;
+
+        OptimalDroneOrders _drone_orders;
+
+        /**
+         * @brief Reorder a short drone route optimally instead of trying all of its reversals.
+         *
+         * The tabu pair of the move is formed by the first and last customers whose positions change.
+         */
+        template <typename _AspirationCriteria>
+        void _optimize_drone_route(
+            const std::shared_ptr<ST> &solution,
+            std::vector<std::vector<DroneRoute>> &drone_routes,
+            utils::TournamentTree<double> &working_times,
+            const std::size_t &index,
+            const std::size_t &route,
+            const _AspirationCriteria &aspiration_criteria,
+            std::shared_ptr<ST> &result,
+            std::pair<std::size_t, std::size_t> &tabu_pair)
+        {
+            auto problem = this->problem;
+            const std::vector<std::size_t> &customers = solution->drone_routes[index][route].customers();
+            auto &optimal = _drone_orders.get(customers);
+            if (optimal.empty() || optimal == customers)
+            {
+                return;
+            }
+
+            std::size_t i = 1, j = customers.size() - 2;
+            while (optimal[i] == customers[i])
+            {
+                i++;
+            }
+
+            while (optimal[j] == customers[j])
+            {
+                j--;
+            }
+
+            const std::size_t vehicle = problem->trucks_count + index;
+            const double working_time = working_times.get(vehicle);
+            drone_routes[index][route] = DroneRoute(problem, optimal);
+            working_times.set(vehicle, this->vehicle_working_time(drone_routes[index]));
+
+            if (this->may_improve(result, working_times))
+            {
+                auto new_solution = std::make_shared<ST>(problem, solution->truck_routes, drone_routes);
+                this->check_working_times(*new_solution, working_times);
+                if (this->is_admissible(*new_solution, customers[i], customers[j], aspiration_criteria) &&
+                    (result == nullptr || new_solution->cost() < result->cost()))
+                {
+                    result.swap(new_solution);
+                    tabu_pair = std::make_pair(customers[i], customers[j]);
+                }
+            }
+
+            // Restore
+            drone_routes[index][route] = solution->drone_routes[index][route];
+            working_times.set(vehicle, working_time);
+        }
+
+        /**
+         * @brief Screening of the reversals of a route by a lower bound of their working times.
+         *
+         * The distance deltas of reversing `[i, j]` are computed for all `j` of a row at once. Each
+         * delta gives a lower bound of the working time of the reversed route (see
+         * `working_time_bound`), hence of the makespan of the candidate solution.
+         */
+        class _Screen
+        {
+        private:
+            const Problem *const _problem;
+            const std::vector<std::size_t> &_customers;
+            const std::vector<double> &_edges;
+            std::vector<double> &_deltas;
+
+            /** @brief The maximum working time of the other vehicles */
+            const double _others;
+
+            /** @brief The working time of the vehicle without this route, plus the base of the bound */
+            const double _base;
+            const double _slope;
+
+            std::size_t _i = 0;
+
+        public:
+            _Screen(
+                const Problem *problem,
+                const std::vector<std::size_t> &customers,
+                const std::vector<double> &edges,
+                std::vector<double> &deltas,
+                const double &others,
+                const double &base,
+                const double &slope)
+                : _problem(problem),
+                  _customers(customers),
+                  _edges(edges),
+                  _deltas(deltas),
+                  _others(others),
+                  _base(base),
+                  _slope(slope) {}
+
+            /** @brief Compute the distance deltas of reversing `[i, j]` for all `j`. */
+            void row(const std::size_t &i)
+            {
+                _i = i;
+                utils::gather_deltas(
+                    _problem->distances[_customers[i - 1]],
+                    _problem->distances[_customers[i]],
+                    _customers.data() + (i + 1),
+                    _edges.data() + (i + 1),
+                    _deltas.data(),
+                    _customers.size() - 2 - i);
+            }
+
+            /**
+             * @brief Whether reversing `[i, j]` may be better than `result`, the best candidate so far.
+             *
+             * The working times of the other vehicles are exact. The bound of the reversed route is
+             * relaxed by a relative tolerance, so that rounding never screens out a candidate that
+             * would have been accepted.
+             */
+            bool may_improve(const std::shared_ptr<ST> &result, const std::size_t &j) const
+            {
+                if (result == nullptr)
+                {
+                    return true;
+                }
+
+                double cost = result->cost(),
+                       delta = _deltas[j - _i - 1] - _edges[_i - 1];
+                if (_others < cost && _base + _slope * delta < cost * (1 + 1e-9))
+                {
+                    return true;
+                }
+
+                TELEMETRY_COUNT(pruned_candidates[utils::telemetry.neighborhood]);
+                return false;
+            }
+        };
+
+        template <typename RT>
+        _Screen _screen(
+            const RT &route,
+            utils::TournamentTree<double> &working_times,
+            const std::size_t &vehicle,
+            std::vector<double> &edges,
+            std::vector<double> &deltas) const
+        {
+            auto problem = this->problem;
+            auto &customers = route.customers();
+
+            edges.resize(customers.size() - 1);
+            for (std::size_t k = 0; k + 1 < customers.size(); k++)
+            {
+                edges[k] = problem->distances[customers[k]][customers[k + 1]];
+            }
+
+            deltas.resize(customers.size());
+
+            double working_time = working_times.get(vehicle);
+            working_times.set(vehicle, 0);
+            double others = working_times.max();
+            working_times.set(vehicle, working_time);
+
+            auto [base, slope] = route.working_time_bound();
+            return _Screen(problem, customers, edges, deltas, others, working_time - route.working_time() + base, slope);
+        }
+
+        template <typename _AspirationCriteria>
         std::pair<std::shared_ptr<ST>, std::pair<std::size_t, std::size_t>> same_route(
             const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria) override
+            const _AspirationCriteria &aspiration_criteria)
         {
-            auto problem = Problem::get_instance();
+            auto problem = this->problem;
             std::shared_ptr<ST> result;
             std::pair<std::size_t, std::size_t> tabu_pair;
 
             std::vector<std::vector<TruckRoute>> truck_routes(solution->truck_routes);
             std::vector<std::vector<DroneRoute>> drone_routes(solution->drone_routes);
+            auto working_times = this->vehicle_working_times(*solution);
+
+            // Buffers of _screen
+            std::vector<double> edges, deltas;
 
-#define MODIFY_ROUTES(vehicles_count, vehicle_routes)                                                                 \
-    {                                                                                                                 \
-        for (std::size_t index = 0; index < problem->vehicles_count; index++)                                         \
-        {                                                                                                             \
-            for (std::size_t route = 0; route < vehicle_routes[index].size(); route++)                                \
-            {                                                                                                         \
-                const std::vector<std::size_t> &customers = solution->vehicle_routes[index][route].customers();       \
-                for (std::size_t i = 1; i + 1 < customers.size(); i++)                                                \
-                {                                                                                                     \
-                    for (std::size_t j = i + 1; j + 1 < customers.size(); j++)                                        \
-                    {                                                                                                 \
-                        /* Temporary reverse segment [i, j] */                                                        \
-                        vehicle_routes[index][route].reverse(i, j - i + 1);                                           \
-                                                                                                                      \
-                        auto new_solution = std::make_shared<ST>(truck_routes, drone_routes);                         \
-                        if ((aspiration_criteria(*new_solution) || !this->is_tabu(customers[i - 1], customers[j])) && \
-                            (result == nullptr || new_solution->cost() < result->cost()))                             \
-                        {                                                                                             \
-                            result.swap(new_solution);                                                                \
-                            tabu_pair = std::make_pair(customers[i - 1], customers[j]);                               \
-                        }                                                                                             \
-                                                                                                                      \
-                        /* Restore */                                                                                 \
-                        vehicle_routes[index][route].reverse(i, j - i + 1);                                           \
-                    }                                                                                                 \
-                }                                                                                                     \
-            }                                                                                                         \
-        }                                                                                                             \
+#define MODIFY_ROUTES(vehicles_offset, vehicles_count, vehicle_routes)                                                                        \
+    {                                                                                                                                         \
+        for (std::size_t index = 0; index < problem->vehicles_count; index++)                                                                 \
+        {                                                                                                                                     \
+            const std::size_t vehicle = vehicles_offset + index;                                                                              \
+            const double working_time = working_times.get(vehicle);                                                                           \
+            for (std::size_t route = 0; route < vehicle_routes[index].size(); route++)                                                        \
+            {                                                                                                                                 \
+                const std::vector<std::size_t> &customers = solution->vehicle_routes[index][route].customers();                               \
+                using VehicleRoute = std::remove_reference_t<decltype(vehicle_routes[index][route])>;                                         \
+                if constexpr (std::is_same_v<VehicleRoute, DroneRoute>)                                                                       \
+                {                                                                                                                             \
+                    if (customers.size() <= DroneRoute::max_optimal_customers + 2)                                                            \
+                    {                                                                                                                         \
+                        _optimize_drone_route(solution, vehicle_routes, working_times, index, route, aspiration_criteria, result, tabu_pair); \
+                        continue;                                                                                                             \
+                    }                                                                                                                         \
+                }                                                                                                                             \
+                                                                                                                                              \
+                auto screen = _screen(solution->vehicle_routes[index][route], working_times, vehicle, edges, deltas);                         \
+                for (std::size_t i = 1; i + 1 < customers.size(); i++)                                                                        \
+                {                                                                                                                             \
+                    screen.row(i);                                                                                                            \
+                    for (std::size_t j = i + 1; j + 1 < customers.size(); j++)                                                                \
+                    {                                                                                                                         \
+                        if (!screen.may_improve(result, j))                                                                                   \
+                        {                                                                                                                     \
+                            continue;                                                                                                         \
+                        }                                                                                                                     \
+                                                                                                                                              \
+                        /* Temporary reverse segment [i, j] */                                                                                \
+                        vehicle_routes[index][route].reverse(i, j - i + 1);                                                                   \
+                        working_times.set(vehicle, this->vehicle_working_time(vehicle_routes[index]));                                        \
+                                                                                                                                              \
+                        if (this->may_improve(result, working_times))                                                                         \
+                        {                                                                                                                     \
+                            auto new_solution = std::make_shared<ST>(problem, truck_routes, drone_routes);                                    \
+                            this->check_working_times(*new_solution, working_times);                                                          \
+                            if (this->is_admissible(*new_solution, customers[i - 1], customers[j], aspiration_criteria) &&                    \
+                                (result == nullptr || new_solution->cost() < result->cost()))                                                 \
+                            {                                                                                                                 \
+                                result.swap(new_solution);                                                                                    \
+                                tabu_pair = std::make_pair(customers[i - 1], customers[j]);                                                   \
+                            }                                                                                                                 \
+                        }                                                                                                                     \
+                                                                                                                                              \
+                        /* Restore */                                                                                                         \
+                        vehicle_routes[index][route].reverse(i, j - i + 1);                                                                   \
+                        working_times.set(vehicle, working_time);                                                                             \
+                    }                                                                                                                         \
+                }                                                                                                                             \
+            }                                                                                                                                 \
+        }                                                                                                                                     \
     }
 
-            MODIFY_ROUTES(trucks_count, truck_routes);
-            MODIFY_ROUTES(drones_count, drone_routes);
+            MODIFY_ROUTES(0, trucks_count, truck_routes);
+            MODIFY_ROUTES(problem->trucks_count, drones_count, drone_routes);
 
 #undef MODIFY_ROUTES
 
             return std::make_pair(result, tabu_pair);
         }
 
+        template <typename _AspirationCriteria>
         std::pair<std::shared_ptr<ST>, std::pair<std::size_t, std::size_t>> multi_route(
             const std::shared_ptr<ST> &solution,
-            const std::function<bool(const ST &)> &aspiration_criteria) override
+            const _AspirationCriteria &aspiration_criteria)
         {
-            auto problem = Problem::get_instance();
+            auto problem = this->problem;
             std::shared_ptr<ST> result;
             std::pair<std::size_t, std::size_t> tabu_pair;
 
             std::vector<std::vector<TruckRoute>> truck_routes(solution->truck_routes);
             std::vector<std::vector<DroneRoute>> drone_routes(solution->drone_routes);
+            auto working_times = this->vehicle_working_times(*solution);
             for (std::size_t vehicle_i = 0; vehicle_i < problem->trucks_count + problem->drones_count; vehicle_i++)
             {
                 for (std::size_t vehicle_j = vehicle_i; vehicle_j < problem->trucks_count + problem->drones_count; vehicle_j++)
@@ -75,6 +277,7 @@ namespace d2d
     {                                                                                                                                                             \
         std::size_t _vehicle_i = vehicle_i < problem->trucks_count ? vehicle_i : vehicle_i - problem->trucks_count,                                               \
                     _vehicle_j = vehicle_j < problem->trucks_count ? vehicle_j : vehicle_j - problem->trucks_count;                                               \
+        const double working_time_i = working_times.get(vehicle_i), working_time_j = working_times.get(vehicle_j);                                                \
         for (std::size_t route_i = 0; route_i < solution->vehicle_routes_i[_vehicle_i].size(); route_i++)                                                         \
         {                                                                                                                                                         \
             for (std::size_t route_j = 0; route_j < solution->vehicle_routes_j[_vehicle_j].size(); route_j++)                                                     \
@@ -103,7 +306,7 @@ namespace d2d
                                                                                                                                                                   \
                         if constexpr (std::is_same_v<VehicleRoute_i, DroneRoute>)                                                                                 \
                         {                                                                                                                                         \
-                            if (std::any_of(ri.begin(), ri.end(), [&problem](const std::size_t &c) { return !problem->customers[c].dronable; }))                  \
+                            if (std::any_of(ri.begin(), ri.end(), [&problem](const std::size_t &c) { return !problem->customer_arrays.dronable[c]; }))            \
                             {                                                                                                                                     \
                                 continue;                                                                                                                         \
                             }                                                                                                                                     \
@@ -111,7 +314,7 @@ namespace d2d
                                                                                                                                                                   \
                         if constexpr (std::is_same_v<VehicleRoute_j, DroneRoute>)                                                                                 \
                         {                                                                                                                                         \
-                            if (std::any_of(rj.begin(), rj.end(), [&problem](const std::size_t &c) { return !problem->customers[c].dronable; }))                  \
+                            if (std::any_of(rj.begin(), rj.end(), [&problem](const std::size_t &c) { return !problem->customer_arrays.dronable[c]; }))            \
                             {                                                                                                                                     \
                                 continue;                                                                                                                         \
                             }                                                                                                                                     \
@@ -124,7 +327,7 @@ namespace d2d
                         }                                                                                                                                         \
                         else                                                                                                                                      \
                         {                                                                                                                                         \
-                            vehicle_routes_i[_vehicle_i][route_i] = VehicleRoute_i(ri);                                                                           \
+                            vehicle_routes_i[_vehicle_i][route_i] = VehicleRoute_i(problem, ri);                                                                  \
                         }                                                                                                                                         \
                                                                                                                                                                   \
                         if (rj_empty)                                                                                                                             \
@@ -133,15 +336,22 @@ namespace d2d
                         }                                                                                                                                         \
                         else                                                                                                                                      \
                         {                                                                                                                                         \
-                            vehicle_routes_j[_vehicle_j][route_j] = VehicleRoute_j(rj);                                                                           \
+                            vehicle_routes_j[_vehicle_j][route_j] = VehicleRoute_j(problem, rj);                                                                  \
                         }                                                                                                                                         \
                                                                                                                                                                   \
-                        auto new_solution = std::make_shared<ST>(truck_routes, drone_routes);                                                                     \
-                        if ((aspiration_criteria(*new_solution) || !this->is_tabu(customers_i[i], customers_j[j])) &&                                             \
-                            (result == nullptr || new_solution->cost() < result->cost()))                                                                         \
+                        working_times.set(vehicle_i, this->vehicle_working_time(vehicle_routes_i[_vehicle_i]));                                                   \
+                        working_times.set(vehicle_j, this->vehicle_working_time(vehicle_routes_j[_vehicle_j]));                                                   \
+                                                                                                                                                                  \
+                        if (this->may_improve(result, working_times))                                                                                             \
                         {                                                                                                                                         \
-                            result.swap(new_solution);                                                                                                            \
-                            tabu_pair = std::make_pair(customers_i[i], customers_j[j]);                                                                           \
+                            auto new_solution = std::make_shared<ST>(problem, truck_routes, drone_routes);                                                        \
+                            this->check_working_times(*new_solution, working_times);                                                                              \
+                            if (this->is_admissible(*new_solution, customers_i[i], customers_j[j], aspiration_criteria) &&                                        \
+                                (result == nullptr || new_solution->cost() < result->cost()))                                                                     \
+                            {                                                                                                                                     \
+                                result.swap(new_solution);                                                                                                        \
+                                tabu_pair = std::make_pair(customers_i[i], customers_j[j]);                                                                       \
+                            }                                                                                                                                     \
                         }                                                                                                                                         \
                                                                                                                                                                   \
                         /* Restore */                                                                                                                             \
@@ -162,6 +372,9 @@ namespace d2d
                         {                                                                                                                                         \
                             vehicle_routes_j[_vehicle_j][route_j] = solution->vehicle_routes_j[_vehicle_j][route_j];                                              \
                         }                                                                                                                                         \
+                                                                                                                                                                  \
+                        working_times.set(vehicle_i, working_time_i);                                                                                             \
+                        working_times.set(vehicle_j, working_time_j);                                                                                             \
                     }                                                                                                                                             \
                 }                                                                                                                                                 \
             }                                                                                                                                                     \
@@ -190,5 +403,13 @@ namespace d2d
 
             return std::make_pair(result, tabu_pair);
         }
+
+    public:
+        TwoOpt(const Problem *problem) : CommonRouteNeighborhood<ST, TwoOpt<ST>>(problem), _drone_orders(problem) {}
+
+        static std::string label()
+        {
+            return "2-opt";
+        }
     };
 }
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "utils.hpp"
+
+namespace utils
+{
+    /**
+     * @brief The maximum number of threads that parallel algorithms called from the current thread may
+     * use, `0` for the hardware concurrency.
+     *
+     * Callers that already run on a thread pool lower it, so that nested parallelism does not
+     * oversubscribe the CPU.
+     */
+    inline thread_local std::size_t max_parallel_threads = 0;
+
+    /**
+     * @brief The number of threads worth splitting `count` items into, with at least `grain` items
+     * per thread.
+     */
+    inline std::size_t parallel_threads(const std::size_t &count, const std::size_t &grain)
+    {
+        auto limit = max_parallel_threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : max_parallel_threads;
+        return std::clamp<std::size_t>(count / std::max<std::size_t>(grain, 1), 1, limit);
+    }
+
+    /**
+     * @brief Call `function(thread, begin, end)` on contiguous chunks covering `[0, count)`, one
+     * chunk per thread.
+     *
+     * The calling thread processes the first chunk itself, so no thread is spawned when the work is
+     * smaller than `grain`.
+     */
+    template <typename _Function>
+    void parallel_for(const std::size_t &count, const std::size_t &grain, _Function &&function)
+    {
+        auto threads = parallel_threads(count, grain);
+        const auto chunk = [&count, &threads](const std::size_t &thread)
+        {
+            return count * thread / threads;
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (std::size_t thread = 1; thread < threads; thread++)
+        {
+            workers.emplace_back(function, thread, chunk(thread), chunk(thread + 1));
+        }
+
+        function(0, chunk(0), chunk(1));
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Sort a random access range by sorting chunks in parallel, then merging them pairwise.
+     *
+     * @note The result is only deterministic if `compare` is a strict total order.
+     */
+    template <typename _RandomAccessIterator, typename _Compare>
+    void parallel_sort(const _RandomAccessIterator &begin, const _RandomAccessIterator &end, const _Compare &compare, const std::size_t &grain = 1 << 14)
+    {
+        std::size_t count = end - begin, threads = parallel_threads(count, grain);
+        if (threads == 1)
+        {
+            std::sort(begin, end, compare);
+            return;
+        }
+
+        std::vector<std::size_t> bounds(threads + 1);
+        for (std::size_t thread = 0; thread <= threads; thread++)
+        {
+            bounds[thread] = count * thread / threads;
+        }
+
+        parallel_for(
+            threads, 1,
+            [&begin, &bounds, &compare](const std::size_t &, const std::size_t &first, const std::size_t &last)
+            {
+                for (auto thread = first; thread < last; thread++)
+                {
+                    std::sort(begin + bounds[thread], begin + bounds[thread + 1], compare);
+                }
+            });
+
+        // Merge sorted runs pairwise, halving their number each round
+        for (std::size_t width = 1; width < threads; width *= 2)
+        {
+            std::size_t merges = (threads + 2 * width - 1) / (2 * width);
+            parallel_for(
+                merges, 1,
+                [&begin, &bounds, &compare, &threads, &width](const std::size_t &, const std::size_t &first, const std::size_t &last)
+                {
+                    for (auto merge = first; merge < last; merge++)
+                    {
+                        auto left = 2 * width * merge, middle = std::min(left + width, threads), right = std::min(left + 2 * width, threads);
+                        if (middle < right)
+                        {
+                            std::inplace_merge(begin + bounds[left], begin + bounds[middle], begin + bounds[right], compare);
+                        }
+                    }
+                });
+        }
+    }
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "aligned.hpp"
 #include "config.hpp"
 #include "format.hpp"
+#include "matrix.hpp"
+#include "route_cache.hpp"
 
 namespace d2d
 {
@@ -31,16 +34,113 @@ namespace d2d
         static Customer depot();
     };
 
-    Customer Customer::depot()
+    inline Customer Customer::depot()
     {
         return Customer(0, 0, 0, true, 0, 0);
     }
 
+    /**
+     * @brief Structure-of-arrays view of a list of customers.
+     *
+     * Each field is stored contiguously, hence hot loops only touch the fields they need and loops
+     * over consecutive customers can be vectorized.
+     */
+    class CustomerArrays
+    {
+    private:
+        static utils::aligned_vector<double> _field(const std::vector<Customer> &customers, const double Customer::*field)
+        {
+            utils::aligned_vector<double> result;
+            result.reserve(customers.size());
+            for (auto &customer : customers)
+            {
+                result.push_back(customer.*field);
+            }
+
+            return result;
+        }
+
+        static std::vector<bool> _dronable(const std::vector<Customer> &customers)
+        {
+            std::vector<bool> result;
+            result.reserve(customers.size());
+            for (auto &customer : customers)
+            {
+                result.push_back(customer.dronable);
+            }
+
+            return result;
+        }
+
+    public:
+        const utils::aligned_vector<double> x, y;
+        const utils::aligned_vector<double> demand;
+        const utils::aligned_vector<double> truck_service_time;
+        const utils::aligned_vector<double> drone_service_time;
+
+        /** @brief Whether each customer can be served by drone, packed as a bitset */
+        const std::vector<bool> dronable;
+
+        CustomerArrays(const std::vector<Customer> &customers)
+            : x(_field(customers, &Customer::x)),
+              y(_field(customers, &Customer::y)),
+              demand(_field(customers, &Customer::demand)),
+              truck_service_time(_field(customers, &Customer::truck_service_time)),
+              drone_service_time(_field(customers, &Customer::drone_service_time)),
+              dronable(_dronable(customers)) {}
+
+        /**
+         * @brief Fill `row[j]` with the squared Euclidean distance from customer `i` to customer `j`,
+         * for all `j`.
+         *
+         * The loop is branch-free over contiguous arrays, so that the compiler can vectorize it.
+         */
+        void squared_distances(const std::size_t &i, double *__restrict row) const
+        {
+            const double *__restrict xs = x.data(), *__restrict ys = y.data();
+            const double xi = xs[i], yi = ys[i];
+            for (std::size_t j = 0; j < x.size(); j++)
+            {
+                row[j] = utils::pow2(xi - xs[j]) + utils::pow2(yi - ys[j]);
+            }
+        }
+    };
+
+    /**
+     * @brief An immutable problem context.
+     *
+     * Routes, solutions, neighborhoods and initial heuristics hold a pointer to the context
+     * they operate on, hence multiple problems can live in the same process.
+     */
     class Problem
     {
     private:
-        static Problem *_instance;
+        inline static std::unique_ptr<Problem> _instance;
+
+        /**
+         * @brief The Euclidean distance matrix of `arrays`.
+         *
+         * Squared distances are computed a whole row at a time, which vectorizes. The square roots
+         * are not vectorizable, hence only taken once per pair as in `utils::distance`.
+         */
+        static utils::SquareMatrix<double> _calculate_distances(const CustomerArrays &arrays)
+        {
+            auto n = arrays.x.size();
+            utils::SquareMatrix<double> distances(n);
+            utils::aligned_vector<double> squared(n);
+            for (std::size_t i = 0; i < n; i++)
+            {
+                arrays.squared_distances(i, squared.data());
+                for (std::size_t j = i + 1; j < n; j++)
+                {
+                    distances.row(i)[j] = distances.row(j)[i] = utils::sqrt(squared[j]);
+                }
+            }
+
+            return distances;
+        }
 
+        /** @brief Construct a problem, computing the distance matrix from `customer_arrays`. */
         Problem(
             const std::size_t &iterations,
             const std::size_t &tabu_size,
@@ -48,7 +148,32 @@ namespace d2d
             const std::size_t &trucks_count,
             const std::size_t &drones_count,
             const std::vector<Customer> &customers,
-            const std::vector<std::vector<double>> &distances,
+            const TruckConfig *const truck,
+            const _BaseDroneConfig *const drone)
+            : iterations(iterations),
+              tabu_size(tabu_size),
+              verbose(verbose),
+              trucks_count(trucks_count),
+              drones_count(drones_count),
+              customers(customers),
+              customer_arrays(customers),
+              distances(_calculate_distances(customer_arrays)),
+              truck(truck),
+              drone(drone),
+              linear(dynamic_cast<const DroneLinearConfig *>(drone)),
+              nonlinear(dynamic_cast<const DroneNonlinearConfig *>(drone)),
+              endurance(dynamic_cast<const DroneEnduranceConfig *>(drone)),
+              zobrist(customers.size()) {}
+
+    public:
+        Problem(
+            const std::size_t &iterations,
+            const std::size_t &tabu_size,
+            const bool verbose,
+            const std::size_t &trucks_count,
+            const std::size_t &drones_count,
+            const std::vector<Customer> &customers,
+            const utils::SquareMatrix<double> &distances,
             const TruckConfig *const truck,
             const _BaseDroneConfig *const drone,
             const DroneLinearConfig *const linear,
@@ -60,12 +185,17 @@ namespace d2d
               trucks_count(trucks_count),
               drones_count(drones_count),
               customers(customers),
+              customer_arrays(customers),
               distances(distances),
               truck(truck),
               drone(drone),
               linear(linear),
               nonlinear(nonlinear),
-              endurance(endurance) {}
+              endurance(endurance),
+              zobrist(customers.size()) {}
+
+        Problem(const Problem &) = delete;
+        Problem &operator=(const Problem &) = delete;
 
         ~Problem()
         {
@@ -73,12 +203,15 @@ namespace d2d
             delete drone;
         }
 
-    public:
         const std::size_t iterations, tabu_size;
         const bool verbose;
         const std::size_t trucks_count, drones_count;
         const std::vector<Customer> customers;
-        const std::vector<std::vector<double>> distances;
+
+        /** @brief The fields of `customers`, stored as separate arrays */
+        const CustomerArrays customer_arrays;
+
+        const utils::SquareMatrix<double> distances;
         const double maximum_waiting_time = 3600; // hard-coded value
         const TruckConfig *const truck;
         const _BaseDroneConfig *const drone;
@@ -86,180 +219,294 @@ namespace d2d
         const DroneNonlinearConfig *const nonlinear;
         const DroneEnduranceConfig *const endurance;
 
+        /** @brief Hashing of routes of this problem */
+        const Zobrist zobrist;
+
+        /**
+         * @brief Attributes of recently built routes, shared by all searches on this problem.
+         *
+         * Caching does not modify the problem itself, hence the caches are mutable.
+         */
+        mutable RouteCache truck_routes_cache, drone_routes_cache;
+
+        /**
+         * @brief Construct a problem from its customers (the depot `0` first) and vehicle configurations,
+         * computing the distance matrix.
+         *
+         * Ownership of `truck` and `drone` is transferred to the returned problem, and stays with the
+         * caller if an exception is thrown.
+         */
+        static std::unique_ptr<Problem> create(
+            const std::size_t &iterations,
+            const std::size_t &tabu_size,
+            const bool verbose,
+            const std::size_t &trucks_count,
+            const std::size_t &drones_count,
+            const std::vector<Customer> &customers,
+            std::unique_ptr<TruckConfig> &&truck,
+            std::unique_ptr<_BaseDroneConfig> &&drone);
+
+        /**
+         * @brief Construct a problem with a pre-calculated distance matrix.
+         *
+         * Ownership of `truck` and `drone` is transferred to the returned problem, and stays with the
+         * caller if an exception is thrown.
+         */
+        static std::unique_ptr<Problem> create(
+            const std::size_t &iterations,
+            const std::size_t &tabu_size,
+            const bool verbose,
+            const std::size_t &trucks_count,
+            const std::size_t &drones_count,
+            const std::vector<Customer> &customers,
+            const utils::SquareMatrix<double> &distances,
+            std::unique_ptr<TruckConfig> &&truck,
+            std::unique_ptr<_BaseDroneConfig> &&drone);
+
+        /**
+         * @brief Read a problem from a whitespace-separated stream, as produced by `scripts/transform.py`.
+         */
+        static std::unique_ptr<Problem> read(std::istream &stream);
+
+        /**
+         * @brief Compatibility wrapper returning a process-wide problem lazily read from `std::cin`.
+         */
         static Problem *get_instance();
     };
 
-    Problem *Problem::_instance = nullptr;
-    Problem *Problem::get_instance()
+    inline Problem *Problem::get_instance()
     {
         if (_instance == nullptr)
         {
-            std::size_t customers_count, trucks_count, drones_count;
-            std::cin >> customers_count >> trucks_count >> drones_count;
+            _instance = read(std::cin);
+        }
 
-            std::vector<double> x(customers_count);
-            for (std::size_t i = 0; i < customers_count; i++)
-            {
-                std::cin >> x[i];
-            }
+        return _instance.get();
+    }
 
-            std::vector<double> y(customers_count);
-            for (std::size_t i = 0; i < customers_count; i++)
-            {
-                std::cin >> y[i];
-            }
+    inline std::unique_ptr<Problem> Problem::read(std::istream &stream)
+    {
+        std::size_t customers_count, trucks_count, drones_count;
+        stream >> customers_count >> trucks_count >> drones_count;
+        if (!stream)
+        {
+            throw std::runtime_error("Malformed problem input: unable to read the number of customers and vehicles");
+        }
 
-            std::vector<double> demands(customers_count);
-            for (std::size_t i = 0; i < customers_count; i++)
-            {
-                std::cin >> demands[i];
-            }
+        std::vector<double> x(customers_count);
+        for (std::size_t i = 0; i < customers_count; i++)
+        {
+            stream >> x[i];
+        }
 
-            std::vector<bool> dronable;
-            for (std::size_t i = 0; i < customers_count; i++)
-            {
-                bool b;
-                std::cin >> b;
-                dronable.push_back(b);
-            }
+        std::vector<double> y(customers_count);
+        for (std::size_t i = 0; i < customers_count; i++)
+        {
+            stream >> y[i];
+        }
 
-            std::vector<double> truck_service_time(customers_count);
-            for (std::size_t i = 0; i < customers_count; i++)
-            {
-                std::cin >> truck_service_time[i];
-            }
+        std::vector<double> demands(customers_count);
+        for (std::size_t i = 0; i < customers_count; i++)
+        {
+            stream >> demands[i];
+        }
 
-            std::vector<double> drone_service_time(customers_count);
-            for (std::size_t i = 0; i < customers_count; i++)
-            {
-                std::cin >> drone_service_time[i];
-            }
+        std::vector<bool> dronable;
+        for (std::size_t i = 0; i < customers_count; i++)
+        {
+            bool b;
+            stream >> b;
+            dronable.push_back(b);
+        }
 
-            std::vector<Customer> customers;
-            customers.push_back(Customer::depot());
-            for (std::size_t i = 0; i < customers_count; i++)
-            {
-                customers.emplace_back(x[i], y[i], demands[i], dronable[i], truck_service_time[i], drone_service_time[i]);
-            }
+        std::vector<double> truck_service_time(customers_count);
+        for (std::size_t i = 0; i < customers_count; i++)
+        {
+            stream >> truck_service_time[i];
+        }
 
-            std::vector<std::vector<double>> distances(customers.size(), std::vector<double>(customers.size()));
-            for (std::size_t i = 0; i < customers.size(); i++)
-            {
-                for (std::size_t j = i + 1; j < customers.size(); j++)
-                {
-                    distances[i][j] = distances[j][i] = utils::distance(
-                        customers[i].x - customers[j].x,
-                        customers[i].y - customers[j].y);
-                }
-            }
+        std::vector<double> drone_service_time(customers_count);
+        for (std::size_t i = 0; i < customers_count; i++)
+        {
+            stream >> drone_service_time[i];
+        }
 
-            std::size_t iterations, tabu_size;
-            bool verbose;
-            std::cin >> iterations >> tabu_size >> verbose;
+        std::vector<Customer> customers;
+        customers.push_back(Customer::depot());
+        for (std::size_t i = 0; i < customers_count; i++)
+        {
+            customers.emplace_back(x[i], y[i], demands[i], dronable[i], truck_service_time[i], drone_service_time[i]);
+        }
 
-            double truck_maximum_velocity, truck_capacity;
-            std::cin >> truck_maximum_velocity >> truck_capacity;
+        std::size_t iterations, tabu_size;
+        bool verbose;
+        stream >> iterations >> tabu_size >> verbose;
 
-            std::size_t truck_coefficients_count;
-            std::cin >> truck_coefficients_count;
-            std::vector<double> truck_coefficients(truck_coefficients_count);
-            for (std::size_t i = 0; i < truck_coefficients_count; i++)
-            {
-                std::cin >> truck_coefficients[i];
-            }
+        double truck_maximum_velocity, truck_capacity;
+        stream >> truck_maximum_velocity >> truck_capacity;
 
-            TruckConfig *truck = new TruckConfig(
-                truck_maximum_velocity,
-                truck_coefficients,
-                truck_capacity);
+        std::size_t truck_coefficients_count;
+        stream >> truck_coefficients_count;
+        std::vector<double> truck_coefficients(truck_coefficients_count);
+        for (std::size_t i = 0; i < truck_coefficients_count; i++)
+        {
+            stream >> truck_coefficients[i];
+        }
 
-            std::string drone_class;
-            std::cin >> drone_class;
+        auto truck = std::make_unique<TruckConfig>(
+            truck_maximum_velocity,
+            truck_coefficients,
+            truck_capacity);
 
-            double capacity;
-            std::string _speed_type;
-            std::string _range_type;
-            std::cin >> capacity >> _speed_type >> _range_type;
+        std::string drone_class;
+        stream >> drone_class;
 
-            StatsType speed_type = _speed_type == "low" ? StatsType::low : StatsType::high,
-                      range_type = _range_type == "low" ? StatsType::low : StatsType::high;
+        double capacity;
+        std::string _speed_type;
+        std::string _range_type;
+        stream >> capacity >> _speed_type >> _range_type;
 
-            _BaseDroneConfig *drone = nullptr;
-            if (drone_class == "DroneLinearConfig")
-            {
-                double takeoff_speed, cruise_speed, landing_speed, altitude, battery, beta, gamma;
-                std::cin >> takeoff_speed >> cruise_speed >> landing_speed >> altitude >> battery >> beta >> gamma;
-                drone = new DroneLinearConfig(
-                    capacity,
-                    speed_type,
-                    range_type,
-                    takeoff_speed,
-                    cruise_speed,
-                    landing_speed,
-                    altitude,
-                    battery,
-                    beta,
-                    gamma);
-            }
-            else if (drone_class == "DroneNonlinearConfig")
-            {
-                double takeoff_speed, cruise_speed, landing_speed, altitude, battery, k1, k2, c1, c2, c4, c5;
-                std::cin >> takeoff_speed >> cruise_speed >> landing_speed >> altitude >> battery >> k1 >> k2 >> c1 >> c2 >> c4 >> c5;
-                drone = new DroneNonlinearConfig(
-                    capacity,
-                    speed_type,
-                    range_type,
-                    takeoff_speed,
-                    cruise_speed,
-                    landing_speed,
-                    altitude,
-                    battery,
-                    k1,
-                    k2,
-                    c1,
-                    c2,
-                    c4,
-                    c5);
-            }
-            else if (drone_class == "DroneEnduranceConfig")
-            {
-                double fixed_time, fixed_distance, drone_speed;
-                std::cin >> fixed_time >> fixed_distance >> drone_speed;
-                drone = new DroneEnduranceConfig(
-                    capacity,
-                    speed_type,
-                    range_type,
-                    fixed_time,
-                    fixed_distance,
-                    drone_speed);
-            }
-            else
-            {
-                throw std::runtime_error(utils::format("Unknown drone energy model \"%s\"", drone_class.c_str()));
-            }
+        StatsType speed_type = _speed_type == "low" ? StatsType::low : StatsType::high,
+                  range_type = _range_type == "low" ? StatsType::low : StatsType::high;
 
-            _instance = new Problem(
+        std::unique_ptr<_BaseDroneConfig> drone;
+        if (drone_class == "DroneLinearConfig")
+        {
+            double takeoff_speed, cruise_speed, landing_speed, altitude, battery, beta, gamma;
+            stream >> takeoff_speed >> cruise_speed >> landing_speed >> altitude >> battery >> beta >> gamma;
+            drone = std::make_unique<DroneLinearConfig>(
+                capacity,
+                speed_type,
+                range_type,
+                takeoff_speed,
+                cruise_speed,
+                landing_speed,
+                altitude,
+                battery,
+                beta,
+                gamma);
+        }
+        else if (drone_class == "DroneNonlinearConfig")
+        {
+            double takeoff_speed, cruise_speed, landing_speed, altitude, battery, k1, k2, c1, c2, c4, c5;
+            stream >> takeoff_speed >> cruise_speed >> landing_speed >> altitude >> battery >> k1 >> k2 >> c1 >> c2 >> c4 >> c5;
+            drone = std::make_unique<DroneNonlinearConfig>(
+                capacity,
+                speed_type,
+                range_type,
+                takeoff_speed,
+                cruise_speed,
+                landing_speed,
+                altitude,
+                battery,
+                k1,
+                k2,
+                c1,
+                c2,
+                c4,
+                c5);
+        }
+        else if (drone_class == "DroneEnduranceConfig")
+        {
+            double fixed_time, fixed_distance, drone_speed;
+            stream >> fixed_time >> fixed_distance >> drone_speed;
+            drone = std::make_unique<DroneEnduranceConfig>(
+                capacity,
+                speed_type,
+                range_type,
+                fixed_time,
+                fixed_distance,
+                drone_speed);
+        }
+        else
+        {
+            throw std::runtime_error(utils::format("Unknown drone energy model \"%s\"", drone_class.c_str()));
+        }
+
+        if (!stream)
+        {
+            throw std::runtime_error("Malformed problem input");
+        }
+
+        return create(
+            iterations,
+            tabu_size,
+            verbose,
+            trucks_count,
+            drones_count,
+            customers,
+            std::move(truck),
+            std::move(drone));
+    }
+
+    inline std::unique_ptr<Problem> Problem::create(
+        const std::size_t &iterations,
+        const std::size_t &tabu_size,
+        const bool verbose,
+        const std::size_t &trucks_count,
+        const std::size_t &drones_count,
+        const std::vector<Customer> &customers,
+        std::unique_ptr<TruckConfig> &&truck,
+        std::unique_ptr<_BaseDroneConfig> &&drone)
+    {
+        // The private constructor is not accessible to std::make_unique
+        auto problem = std::unique_ptr<Problem>(
+            new Problem(
                 iterations,
                 tabu_size,
                 verbose,
                 trucks_count,
                 drones_count,
                 customers,
-                distances,
-                truck,
-                drone,
-                dynamic_cast<DroneLinearConfig *>(drone),
-                dynamic_cast<DroneNonlinearConfig *>(drone),
-                dynamic_cast<DroneEnduranceConfig *>(drone));
+                truck.get(),
+                drone.get()));
+
+        // The problem owns the configurations from now on
+        truck.release();
+        drone.release();
+        return problem;
+    }
+
+    inline std::unique_ptr<Problem> Problem::create(
+        const std::size_t &iterations,
+        const std::size_t &tabu_size,
+        const bool verbose,
+        const std::size_t &trucks_count,
+        const std::size_t &drones_count,
+        const std::vector<Customer> &customers,
+        const utils::SquareMatrix<double> &distances,
+        std::unique_ptr<TruckConfig> &&truck,
+        std::unique_ptr<_BaseDroneConfig> &&drone)
+    {
+        if (distances.size() != customers.size())
+        {
+            throw std::invalid_argument(utils::format("Expected a %lux%lu distance matrix, got %lux%lu", customers.size(), customers.size(), distances.size(), distances.size()));
         }
 
-        return _instance;
+        auto problem = std::make_unique<Problem>(
+            iterations,
+            tabu_size,
+            verbose,
+            trucks_count,
+            drones_count,
+            customers,
+            distances,
+            truck.get(),
+            drone.get(),
+            dynamic_cast<const DroneLinearConfig *>(drone.get()),
+            dynamic_cast<const DroneNonlinearConfig *>(drone.get()),
+            dynamic_cast<const DroneEnduranceConfig *>(drone.get()));
+
+        // The problem owns the configurations from now on
+        truck.release();
+        drone.release();
+        return problem;
     }
 }
 
 namespace std
 {
-    ostream &operator<<(ostream &stream, const d2d::Customer &customer)
+    inline ostream &operator<<(ostream &stream, const d2d::Customer &customer)
     {
         stream << "Customer(x=" << customer.x << ", y=" << customer.y << ", demand=" << customer.demand << ", dronable=" << customer.dronable << ")";
         return stream;
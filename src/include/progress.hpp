@@ -0,0 +1,192 @@
+#pragma once
+
+#include "utils.hpp"
+
+namespace utils
+{
+    enum class ProgressFormat
+    {
+        /** @brief A progress bar redrawn in place on stderr */
+        terminal,
+        /** @brief Plain text lines on stderr */
+        log,
+        /** @brief JSON lines on stderr */
+        json
+    };
+
+    /**
+     * @brief Reports the progress of a search from a background thread.
+     *
+     * The search only publishes its state through relaxed atomic stores in `update`; formatting,
+     * console queries and flushing happen on the reporter thread at a fixed rate, so that reporting
+     * costs the search next to nothing. All formats write to stderr, leaving stdout to the solution.
+     */
+    class ProgressReporter
+    {
+    private:
+        const ProgressFormat _format;
+        const std::size_t _total;
+        const std::chrono::milliseconds _interval;
+        const std::chrono::steady_clock::time_point _start;
+
+        std::atomic<std::size_t> _iteration;
+        std::atomic<double> _best_cost;
+
+        std::mutex _mutex;
+        std::condition_variable _stop_signal;
+        bool _stop = false;
+        std::thread _reporter;
+
+        void _report(const std::size_t &iteration, const double &best_cost) const;
+        void _run();
+
+    public:
+        /**
+         * @param format The output format
+         * @param total The total number of iterations
+         * @param interval The sampling period
+         */
+        ProgressReporter(
+            const ProgressFormat &format,
+            const std::size_t &total,
+            const std::chrono::milliseconds &interval = std::chrono::milliseconds(100));
+
+        ProgressReporter(const ProgressReporter &) = delete;
+        ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+        /** @brief Report the final state and stop the reporter thread. */
+        ~ProgressReporter();
+
+        /** @brief Publish the number of completed iterations and the best cost so far. */
+        void update(const std::size_t &iteration, const double &best_cost)
+        {
+            _best_cost.store(best_cost, std::memory_order_relaxed);
+            _iteration.store(iteration, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Parse a format name: "terminal", "log" or "json".
+         * @note `std::invalid_argument` is thrown on unknown names.
+         */
+        static ProgressFormat parse_format(const std::string &name);
+    };
+
+    inline ProgressReporter::ProgressReporter(
+        const ProgressFormat &format,
+        const std::size_t &total,
+        const std::chrono::milliseconds &interval)
+        : _format(format),
+          _total(total),
+          _interval(interval),
+          _start(std::chrono::steady_clock::now()),
+          _iteration(0),
+          _best_cost(std::numeric_limits<double>::infinity())
+    {
+        _reporter = std::thread(&ProgressReporter::_run, this);
+    }
+
+    inline ProgressReporter::~ProgressReporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _stop_signal.notify_one();
+        _reporter.join();
+    }
+
+    inline void ProgressReporter::_report(const std::size_t &iteration, const double &best_cost) const
+    {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+        switch (_format)
+        {
+        case ProgressFormat::terminal:
+        {
+            auto line = format("Iteration #%lu/%lu(%.2lf) ", iteration, _total, best_cost);
+            try
+            {
+                auto width = get_console_size().first;
+                const std::size_t excess = 10;
+                if (line.size() + excess < width)
+                {
+                    auto total = width - line.size() - excess,
+                         cover = _total == 0 ? total : (iteration * total + _total - 1) / _total;
+                    line += '[' + std::string(cover, '#') + std::string(total - cover, ' ') + ']';
+                }
+            }
+            catch (std::runtime_error &)
+            {
+                // pass
+            }
+
+            std::cerr << line << '\r' << std::flush;
+            break;
+        }
+
+        case ProgressFormat::log:
+            std::cerr << format("[%.1lfs] iteration %lu/%lu, best cost %.2lf", elapsed, iteration, _total, best_cost) << std::endl;
+            break;
+
+        case ProgressFormat::json:
+            std::cerr << format(
+                             "{\"elapsed\": %.6lf, \"iteration\": %lu, \"total\": %lu, \"best_cost\": %.6lf}",
+                             elapsed, iteration, _total, best_cost)
+                      << std::endl;
+            break;
+        }
+    }
+
+    inline void ProgressReporter::_run()
+    {
+        std::size_t reported = 0; // Nothing to show until the first iteration completes
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            bool stop = _stop_signal.wait_for(
+                lock,
+                _interval,
+                [this]()
+                {
+                    return _stop;
+                });
+
+            auto iteration = _iteration.load(std::memory_order_relaxed);
+            if (iteration != reported || stop)
+            {
+                _report(iteration, _best_cost.load(std::memory_order_relaxed));
+                reported = iteration;
+            }
+
+            if (stop)
+            {
+                if (_format == ProgressFormat::terminal)
+                {
+                    std::cerr << std::endl;
+                }
+
+                return;
+            }
+        }
+    }
+
+    inline ProgressFormat ProgressReporter::parse_format(const std::string &name)
+    {
+        if (name == "terminal")
+        {
+            return ProgressFormat::terminal;
+        }
+
+        if (name == "log")
+        {
+            return ProgressFormat::log;
+        }
+
+        if (name == "json")
+        {
+            return ProgressFormat::json;
+        }
+
+        throw std::invalid_argument(format("Unknown progress format \"%s\"", name.c_str()));
+    }
+}
@@ -4,8 +4,13 @@
 
 namespace utils
 {
-    /** @brief A random number generator */
-    std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
+    /**
+     * @brief A random number generator, one per thread so that concurrent searches
+     * neither race nor share a sequence.
+     */
+    inline thread_local std::mt19937 rng(
+        std::chrono::steady_clock::now().time_since_epoch().count() ^
+        std::hash<std::thread::id>()(std::this_thread::get_id()));
 
     /**
      * @brief Generate a random number in the range `[l, r]`
@@ -28,7 +33,7 @@ namespace utils
      * @param count The number of elements to select
      * @return The index of selected elements
      */
-    std::vector<std::size_t> weighted_random(const std::vector<double> &weights, const std::size_t count = 1)
+    inline std::vector<std::size_t> weighted_random(const std::vector<double> &weights, const std::size_t count = 1)
     {
         std::size_t n = weights.size();
         if (count > n)
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "loader.hpp"
+#include "solutions.hpp"
+#include "timings.hpp"
+#include "writer.hpp"
+
+namespace d2d
+{
+    /**
+     * @brief Write the routes of a set of vehicles as nested JSON arrays of customer indices.
+     */
+    template <typename RT>
+    void _write_routes(utils::BufferedWriter &writer, const std::vector<std::vector<RT>> &vehicle_routes)
+    {
+        writer.put('[');
+        for (std::size_t vehicle = 0; vehicle < vehicle_routes.size(); vehicle++)
+        {
+            writer.write(vehicle == 0 ? "[" : ", [");
+            auto &routes = vehicle_routes[vehicle];
+            for (std::size_t route = 0; route < routes.size(); route++)
+            {
+                writer.write(route == 0 ? "[" : ", [");
+                auto &customers = routes[route].customers();
+                for (std::size_t i = 0; i < customers.size(); i++)
+                {
+                    if (i > 0)
+                    {
+                        writer.write(", ");
+                    }
+
+                    writer.write_number(customers[i]);
+                }
+
+                writer.put(']');
+            }
+
+            writer.put(']');
+        }
+
+        writer.put(']');
+    }
+
+    /**
+     * @brief Write a solution as a single-line JSON record.
+     *
+     * The record holds the instance and its configuration, the cost, the feasibility metrics, the
+     * duration of each phase (`timings`, in seconds), the improvement history of the search, the
+     * total elapsed time and the routes. No newline is written.
+     */
+    inline void write_solution_record(
+        utils::BufferedWriter &writer,
+        const std::string &name,
+        const ProblemOptions &options,
+        const Solution &solution,
+        const utils::PhaseTimings &timings,
+        const std::vector<std::pair<double, double>> &history,
+        const double &elapsed)
+    {
+        writer.write("{\"instance\": ").write_string(name);
+        writer.write(", \"config\": ").write_string(options.config);
+        writer.write(", \"speed_type\": ").write_string(options.speed_type);
+        writer.write(", \"range_type\": ").write_string(options.range_type);
+        writer.write(", \"iterations\": ").write_number(options.iterations);
+        writer.write(", \"seed\": ");
+        if (options.seed.has_value())
+        {
+            writer.write_number(options.seed.value());
+        }
+        else
+        {
+            writer.write("null");
+        }
+
+        writer.write(", \"cost\": ").write_number(solution.cost());
+        writer.write(", \"working_time\": ").write_number(solution.working_time);
+        writer.write(", \"feasible\": ").write_bool(solution.feasible());
+        writer.write(", \"drone_energy_violation\": ").write_number(solution.drone_energy_violation);
+        writer.write(", \"capacity_violation\": ").write_number(solution.capacity_violation);
+        writer.write(", \"waiting_time_violation\": ").write_number(solution.waiting_time_violation);
+
+        writer.write(", \"timings\": {");
+        auto &phases = timings.phases();
+        for (std::size_t i = 0; i < phases.size(); i++)
+        {
+            if (i > 0)
+            {
+                writer.write(", ");
+            }
+
+            writer.write_string(phases[i].first).write(": ").write_number(phases[i].second);
+        }
+
+        writer.write("}, \"history\": [");
+        for (std::size_t i = 0; i < history.size(); i++)
+        {
+            writer.write(i == 0 ? "[" : ", [").write_number(history[i].first).write(", ").write_number(history[i].second).put(']');
+        }
+
+        writer.write("], \"elapsed\": ").write_number(elapsed);
+        writer.write(", \"truck_routes\": ");
+        _write_routes(writer, solution.truck_routes);
+        writer.write(", \"drone_routes\": ");
+        _write_routes(writer, solution.drone_routes);
+        writer.put('}');
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "fenwick.hpp"
+#include "threshold_sum.hpp"
+
+namespace d2d
+{
+    /**
+     * @brief Zobrist hashing of routes, i.e. of their sets of directed edges.
+     *
+     * A route visits each customer once, so its directed edges determine its order. The key of an
+     * edge `from -> to` is the product of random keys of `from` and `to` (the latter made odd), so
+     * that only `n` keys are stored instead of `n * n`. Modifying a few edges of a route updates
+     * its hash in time proportional to the number of modified edges.
+     */
+    class Zobrist
+    {
+    private:
+        std::vector<std::uint64_t> _keys;
+
+    public:
+        /** @param n The number of customers, including the depot */
+        Zobrist(const std::size_t &n) : _keys(n)
+        {
+            // SplitMix64, deterministic so that hashes are reproducible across runs
+            std::uint64_t state = 0;
+            for (auto &key : _keys)
+            {
+                std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                key = z ^ (z >> 31);
+            }
+        }
+
+        /** @brief The key of the directed edge `from -> to`. */
+        std::uint64_t key(const std::size_t &from, const std::size_t &to) const
+        {
+            return _keys[from] * (_keys[to] | 1);
+        }
+
+        /**
+         * @brief The XOR of the keys of the edges `customers[i] -> customers[i + 1]` for `i` in
+         * `[begin, end)`.
+         */
+        std::uint64_t hash(const std::vector<std::size_t> &customers, const std::size_t &begin, const std::size_t &end) const
+        {
+            std::uint64_t result = 0;
+            for (std::size_t i = begin; i < end; i++)
+            {
+                result ^= key(customers[i], customers[i + 1]);
+            }
+
+            return result;
+        }
+
+        /** @brief The hash of a route. */
+        std::uint64_t hash(const std::vector<std::size_t> &customers) const
+        {
+            return hash(customers, 0, customers.size() - 1);
+        }
+    };
+
+    /** @brief The attributes of a route that only depend on its order of customers. */
+    struct RouteAttributes
+    {
+        std::vector<std::size_t> customers;
+        utils::FenwickTree<double> time_segments;
+        utils::ThresholdSum<double> completion_times;
+        double distance;
+        double weight;
+
+        /** @brief Always `0` for truck routes */
+        double energy_consumption;
+
+        /** @brief The Zobrist hash of `customers` */
+        std::uint64_t hash;
+    };
+
+    /**
+     * @brief A bounded, thread-safe map from Zobrist hashes of routes to their attributes.
+     *
+     * The cache is direct-mapped: a route can only be stored in the slot selected by the low bits
+     * of its hash, replacing the previous occupant. Slots are spread over independently locked
+     * shards by the high bits of their hashes. Lookups compare customers, hence hash collisions only
+     * cost a miss.
+     *
+     * Most routes are only built once, caching them would evict useful entries for nothing. A route
+     * is therefore only admitted into the cache when it is missed twice in a row.
+     */
+    class RouteCache
+    {
+    private:
+        static constexpr std::size_t _shards_count = 16;
+
+        struct _Shard
+        {
+            std::mutex mutex;
+
+            /** @brief Cached attributes, vacant slots have no customers */
+            std::vector<RouteAttributes> slots;
+
+            /** @brief The hash of the latest route missed per slot */
+            std::vector<std::uint64_t> missed;
+        };
+
+        std::array<_Shard, _shards_count> _shards;
+
+    public:
+        /** @param capacity The maximum number of cached routes, rounded up to a power of 2 */
+        RouteCache(const std::size_t &capacity = 1 << 12)
+        {
+            for (auto &shard : _shards)
+            {
+                shard.slots.resize(std::bit_ceil(std::max<std::size_t>(capacity / _shards_count, 1)));
+                shard.missed.resize(shard.slots.size());
+            }
+        }
+
+        /**
+         * @brief Look up the route `customers` with hash `attributes.hash`.
+         *
+         * @param attributes Receives the cached attributes on a hit
+         * @param admit Set on a miss: whether the route should be inserted once calculated
+         * @return Whether the route was found
+         */
+        bool find(const std::vector<std::size_t> &customers, RouteAttributes &attributes, bool &admit)
+        {
+            auto hash = attributes.hash;
+            auto &shard = _shards[hash >> 60];
+            auto index = hash & (shard.slots.size() - 1);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            auto &slot = shard.slots[index];
+            if (slot.hash == hash && slot.customers == customers)
+            {
+                attributes = slot;
+                return true;
+            }
+
+            admit = shard.missed[index] == hash;
+            shard.missed[index] = hash;
+            return false;
+        }
+
+        /** @brief Cache the attributes of a route, evicting the occupant of its slot. */
+        void insert(const RouteAttributes &attributes)
+        {
+            auto hash = attributes.hash;
+            auto &shard = _shards[hash >> 60];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            // Copy assignment reuses the memory of the evicted entry
+            shard.slots[hash & (shard.slots.size() - 1)] = attributes;
+        }
+    };
+}
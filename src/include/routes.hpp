@@ -1,54 +1,166 @@
 #pragma once
 
+#include "checks.hpp"
 #include "errors.hpp"
 #include "fenwick.hpp"
 #include "problem.hpp"
+#include "telemetry.hpp"
+#include "threshold_sum.hpp"
 
 namespace d2d
 {
     class _BaseRoute
     {
     protected:
-        static double _calculate_distance(const std::vector<std::size_t> &customers);
-        static double _calculate_weight(const std::vector<std::size_t> &customers);
-        static utils::FenwickTree<double> _calculate_waiting_time_violations(
+        static double _calculate_distance(const Problem *problem, const std::vector<std::size_t> &customers);
+        static double _calculate_weight(const Problem *problem, const std::vector<std::size_t> &customers);
+        template <typename _ServiceTime>
+        static void _extend_completion_times(
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments,
-            const std::function<double(const std::size_t &)> service_time);
+            const _ServiceTime &service_time,
+            utils::ThresholdSum<double> &completion_times);
 
+        const Problem *_problem;
         std::vector<std::size_t> _customers;
         utils::FenwickTree<double> _time_segments;
-        utils::FenwickTree<double> _waiting_time_violations;
+        utils::ThresholdSum<double> _completion_times;
         double _distance;
         double _weight;
         double _working_time;
+        double _waiting_time_violation;
+        std::uint64_t _hash;
 
         _BaseRoute(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments,
-            const utils::FenwickTree<double> &waiting_time_violations,
+            const utils::ThresholdSum<double> &completion_times,
             const double &distance,
             const double &weight)
-            : _customers(customers),
+            : _problem(problem),
+              _customers(customers),
               _time_segments(time_segments),
-              _waiting_time_violations(waiting_time_violations),
+              _completion_times(completion_times),
               _distance(distance),
               _weight(weight),
-              _working_time(time_segments.sum())
+              _working_time(time_segments.sum()),
+              _waiting_time_violation(_calculate_waiting_time_violation()),
+              _hash(problem->zobrist.hash(customers))
+        {
+            _check_customers();
+        }
+
+        /** @brief Construct a route from attributes, which are moved from. */
+        _BaseRoute(const Problem *problem, RouteAttributes &&attributes)
+            : _problem(problem),
+              _customers(std::move(attributes.customers)),
+              _time_segments(std::move(attributes.time_segments)),
+              _completion_times(std::move(attributes.completion_times)),
+              _distance(attributes.distance),
+              _weight(attributes.weight),
+              _working_time(_time_segments.sum()),
+              _waiting_time_violation(_calculate_waiting_time_violation()),
+              _hash(attributes.hash)
+        {
+            _check_customers();
+        }
+
+        void _check_customers() const
         {
 #ifdef DEBUG
-            if (customers.size() < 3)
+            if (_customers.size() < 3)
             {
                 throw std::runtime_error("Empty routes are not allowed");
             }
 
-            if (customers.front() != 0 || customers.back() != 0)
+            if (_customers.front() != 0 || _customers.back() != 0)
             {
                 throw std::runtime_error("Routes must start and end at the depot");
             }
 #endif
         }
 
+        /**
+         * @brief The attributes of the route `customers`, looked up in `cache`, or calculated by
+         * `calculate(attributes)` on a miss.
+         */
+        template <typename _Calculate>
+        static RouteAttributes _cached_attributes(
+            const Problem *problem,
+            const std::vector<std::size_t> &customers,
+            RouteCache &cache,
+            const _Calculate &calculate)
+        {
+            RouteAttributes attributes;
+            attributes.hash = problem->zobrist.hash(customers);
+
+            bool admit = false;
+            if (cache.find(customers, attributes, admit))
+            {
+                TELEMETRY_COUNT(route_cache_hits);
+#ifdef DEBUG
+                if (utils::debug_checks.sample())
+                {
+                    RouteAttributes verify;
+                    calculate(verify);
+                    if (!utils::approximate(attributes.time_segments, verify.time_segments) ||
+                        !utils::approximate(attributes.completion_times.keys(), verify.completion_times.keys()) ||
+                        !utils::approximate(attributes.distance, verify.distance) ||
+                        !utils::approximate(attributes.weight, verify.weight) ||
+                        !utils::approximate(attributes.energy_consumption, verify.energy_consumption))
+                    {
+                        throw std::runtime_error("Inconsistent cached route attributes, possibly an error in hashing");
+                    }
+                }
+#endif
+
+                return attributes;
+            }
+
+            calculate(attributes);
+            if (admit)
+            {
+                cache.insert(attributes);
+            }
+
+            return attributes;
+        }
+
+        /** @brief The hash of this route after appending `customer`. */
+        std::uint64_t _appended_hash(const std::size_t &customer) const
+        {
+            auto &zobrist = _problem->zobrist;
+            auto old_last = _customers[_customers.size() - 2];
+            return _hash ^ zobrist.key(old_last, 0) ^ zobrist.key(old_last, customer) ^ zobrist.key(customer, 0);
+        }
+
+        /** @brief Check the structural invariants of this route, without recalculating anything. */
+        void _check_invariants() const
+        {
+#ifdef DEBUG
+            if (_customers.size() < 3 || _customers.front() != 0 || _customers.back() != 0)
+            {
+                throw std::runtime_error("Routes must start and end at the depot and serve at least 1 customer");
+            }
+
+            if (_time_segments.size() + 1 != _customers.size() || _completion_times.size() != _customers.size())
+            {
+                throw std::runtime_error("Inconsistent number of time segments or completion times");
+            }
+
+            if (!utils::approximate(_working_time, _time_segments.sum()))
+            {
+                throw std::runtime_error("Inconsistent working time, possibly an error in calculation");
+            }
+
+            if (!std::isfinite(_distance) || _distance < 0 || !std::isfinite(_weight) || _weight < 0)
+            {
+                throw std::runtime_error(utils::format("Invalid distance %lf or weight %lf", _distance, _weight));
+            }
+#endif
+        }
+
         template <typename T, std::enable_if_t<std::is_base_of_v<_BaseRoute, T>, bool> = true>
         void _verify(const T &verify) const
         {
@@ -58,9 +170,14 @@ namespace d2d
                 throw std::runtime_error("Inconsistent time segments, possibly an error in calculation");
             }
 
-            if (!utils::approximate(_waiting_time_violations, verify._waiting_time_violations))
+            if (!utils::approximate(_completion_times.keys(), verify._completion_times.keys()))
+            {
+                throw std::runtime_error("Inconsistent completion times, possibly an error in calculation");
+            }
+
+            if (!utils::approximate(_waiting_time_violation, verify._waiting_time_violation))
             {
-                throw std::runtime_error("Inconsistent waiting time violations, possibly an error in calculation");
+                throw std::runtime_error("Inconsistent waiting time violation, possibly an error in calculation");
             }
 
             if (!utils::approximate(_distance, verify._distance))
@@ -72,19 +189,67 @@ namespace d2d
             {
                 throw std::runtime_error("Inconsistent weight, possibly an error in calculation");
             }
+
+            if (_hash != verify._hash)
+            {
+                throw std::runtime_error("Inconsistent hash, possibly an error in calculation");
+            }
 #endif
         }
 
-        template <typename T, std::enable_if_t<std::is_base_of_v<_BaseRoute, T> && std::is_constructible_v<T, const std::vector<std::size_t> &>, bool> = true>
+        template <typename T, std::enable_if_t<std::is_base_of_v<_BaseRoute, T> && std::is_constructible_v<T, const Problem *, const std::vector<std::size_t> &>, bool> = true>
         void _verify() const
         {
-            _verify<T>(T(_customers));
+            _verify<T>(T(_problem, _customers));
+        }
+
+        /**
+         * @brief The total waiting time violation, given the current completion times and working
+         * time.
+         *
+         * A customer waits from the completion of its service until the end of the route, so it
+         * exceeds the maximum waiting time iff its service completes before
+         * `working_time - maximum_waiting_time`.
+         */
+        double _calculate_waiting_time_violation() const
+        {
+            return _completion_times.sum_below(_working_time - _problem->maximum_waiting_time);
+        }
+
+        /**
+         * @brief The total waiting time violation after replacing the final depot with a customer
+         * completing its service at `completion_time` and returning at `working_time`.
+         */
+        double _appended_waiting_time_violation(const double &completion_time, const double &working_time) const
+        {
+            auto threshold = working_time - _problem->maximum_waiting_time;
+            return _completion_times.sum_below(threshold, _completion_times.size() - 1) + std::max(0.0, threshold - completion_time);
+        }
+
+        /**
+         * @brief Recalculate the completion times from index `offset` onwards (those before are
+         * unchanged), then the total waiting time violation.
+         *
+         * @note Time complexity `O(logn + n - offset)`
+         */
+        template <typename _ServiceTime>
+        void _update_completion_times(const std::size_t &offset, const _ServiceTime &service_time)
+        {
+            _completion_times.truncate(offset);
+            _extend_completion_times(_customers, _time_segments, service_time, _completion_times);
+            _waiting_time_violation = _calculate_waiting_time_violation();
         }
 
     public:
         /** @brief The amount of weight exceeding vehicle capacity. */
         virtual double capacity_violation() const = 0;
 
+        /** @brief The problem context this route belongs to. */
+        const Problem *problem() const
+        {
+            return _problem;
+        }
+
         /**
          * @brief The order of customers in this route, starting and ending at the depot `0`.
          */
@@ -106,11 +271,20 @@ namespace d2d
         }
 
         /**
-         * @brief The waiting time violations of each customer in this route.
+         * @brief The moments each customer in this route finishes being served, measured from the
+         * start of the route.
+         */
+        const utils::ThresholdSum<double> &completion_times() const
+        {
+            return _completion_times;
+        }
+
+        /**
+         * @brief The total waiting time violation of customers in this route.
          */
-        const utils::FenwickTree<double> &waiting_time_violations() const
+        double waiting_time_violation() const
         {
-            return _waiting_time_violations;
+            return _waiting_time_violation;
         }
 
         /**
@@ -136,11 +310,16 @@ namespace d2d
         {
             return _working_time;
         }
+
+        /** @brief The Zobrist hash of the order of customers, see `Zobrist`. */
+        std::uint64_t hash() const
+        {
+            return _hash;
+        }
     };
 
-    double _BaseRoute::_calculate_distance(const std::vector<std::size_t> &customers)
+    inline double _BaseRoute::_calculate_distance(const Problem *problem, const std::vector<std::size_t> &customers)
     {
-        auto problem = Problem::get_instance();
         double distance = 0;
         for (std::size_t i = 1; i < customers.size(); i++)
         {
@@ -150,97 +329,243 @@ namespace d2d
         return distance;
     }
 
-    double _BaseRoute::_calculate_weight(const std::vector<std::size_t> &customers)
+    inline double _BaseRoute::_calculate_weight(const Problem *problem, const std::vector<std::size_t> &customers)
     {
-        auto problem = Problem::get_instance();
         double weight = 0;
         for (auto &customer : customers)
         {
-            weight += problem->customers[customer].demand;
+            weight += problem->customer_arrays.demand[customer];
         }
 
         return weight;
     }
 
-    utils::FenwickTree<double> _BaseRoute::_calculate_waiting_time_violations(
+    /**
+     * @brief Append the completion times of `customers[completion_times.size()..]`.
+     *
+     * Since a time segment includes the service time of its first customer, completion times are
+     * nondecreasing along a route.
+     */
+    template <typename _ServiceTime>
+    void _BaseRoute::_extend_completion_times(
         const std::vector<std::size_t> &customers,
         const utils::FenwickTree<double> &time_segments,
-        const std::function<double(const std::size_t &)> service_time)
+        const _ServiceTime &service_time,
+        utils::ThresholdSum<double> &completion_times)
     {
-        auto problem = Problem::get_instance();
-        utils::FenwickTree<double> violations;
-        violations.reserve(customers.size());
+        auto offset = completion_times.size();
+        completion_times.reserve(customers.size());
 
-        double time = time_segments.sum();
-        for (std::size_t i = 0; i < customers.size(); i++)
+        double time = time_segments.sum(0, offset);
+        for (std::size_t i = offset; i < customers.size(); i++)
         {
-            violations.push_back(std::max(0.0, time - service_time(customers[i]) - problem->maximum_waiting_time));
-            time -= time_segments.get(i);
+            completion_times.push_back(time + service_time(customers[i]));
+            if (i < time_segments.size())
+            {
+                time += time_segments.get(i);
+            }
         }
-
-        return violations;
     }
 
+    /**
+     * @brief The attributes a route would have after appending a customer, see
+     * `TruckRoute::probe_push_back` and `DroneRoute::probe_push_back`.
+     */
+    struct AppendProbe
+    {
+        double working_time;
+        double capacity_violation;
+        double waiting_time_violation;
+
+        /** @brief Always `0` for truck routes */
+        double energy_violation;
+
+        /** @brief Whether the route would satisfy all constraints after appending the customer. */
+        bool feasible() const
+        {
+            return capacity_violation == 0 && waiting_time_violation == 0 && energy_violation == 0;
+        }
+    };
+
     /** @brief Represents a truck route. */
     class TruckRoute : public _BaseRoute
     {
     private:
-        static utils::FenwickTree<double> _calculate_time_segments(const std::vector<std::size_t> &customers);
-        static utils::FenwickTree<double> _calculate_waiting_time_violations(
+        /** @brief The service time of customers by truck */
+        static auto _service_time(const Problem *problem)
+        {
+            return [problem](const std::size_t &customer)
+            {
+                return problem->customer_arrays.truck_service_time[customer];
+            };
+        }
+
+        static utils::FenwickTree<double> _calculate_time_segments(const Problem *problem, const std::vector<std::size_t> &customers);
+        static utils::ThresholdSum<double> _calculate_completion_times(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments);
 
+        /** @brief The attributes of the route `customers`, see `Problem::truck_routes_cache`. */
+        static RouteAttributes _attributes(const Problem *problem, const std::vector<std::size_t> &customers)
+        {
+            return _cached_attributes(
+                problem, customers, problem->truck_routes_cache,
+                [&problem, &customers](RouteAttributes &attributes)
+                {
+                    attributes.customers = customers;
+                    attributes.time_segments = _calculate_time_segments(problem, customers);
+                    attributes.completion_times = _calculate_completion_times(problem, customers, attributes.time_segments);
+                    attributes.distance = _calculate_distance(problem, customers);
+                    attributes.weight = _calculate_weight(problem, customers);
+                    attributes.energy_consumption = 0;
+                });
+        }
+
+        TruckRoute(const Problem *problem, RouteAttributes &&attributes) : _BaseRoute(problem, std::move(attributes)) {}
+
+        /**
+         * @brief The time segments from the last customer to `customer`, then from `customer` back
+         * to the depot.
+         */
+        std::pair<double, double> _appended_time_segments(const std::size_t &customer) const
+        {
+            auto problem = _problem;
+
+            double time_offset = _time_segments.sum(0, _time_segments.size() - 1);
+            std::size_t coefficients_index = time_offset / 3600.0;
+            double current_within_timespan = time_offset - 3600.0 * coefficients_index;
+
+            const auto shift = [&coefficients_index, &current_within_timespan](double *time_segment_ptr, double dt)
+            {
+                *time_segment_ptr += dt;
+                current_within_timespan += dt;
+                if (current_within_timespan >= 3600)
+                {
+                    current_within_timespan -= 3600;
+                    coefficients_index++;
+                }
+            };
+
+            const auto travel = [&problem, &shift, &coefficients_index, &current_within_timespan](const std::size_t &from, const std::size_t &to)
+            {
+                double time_segment = 0, distance = problem->distances[from][to];
+                shift(&time_segment, problem->customer_arrays.truck_service_time[from]);
+                while (distance > 0)
+                {
+                    double speed = problem->truck->speed(coefficients_index),
+                           distance_shift = std::min(distance, speed * (3600.0 - current_within_timespan));
+
+                    distance -= distance_shift;
+                    shift(&time_segment, distance_shift / speed);
+                }
+
+                return time_segment;
+            };
+
+            auto first = travel(_customers[_customers.size() - 2], customer);
+            return std::make_pair(first, travel(customer, 0));
+        }
+
     protected:
         void _verify()
         {
 #ifdef DEBUG
-            _BaseRoute::_verify<TruckRoute>();
+            _check_invariants();
+            if (utils::debug_checks.sample())
+            {
+                _BaseRoute::_verify<TruckRoute>();
+            }
 #endif
         }
 
     public:
         /** @brief Construct a `TruckRoute` with pre-calculated attributes */
         TruckRoute(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments,
-            const utils::FenwickTree<double> &waiting_time_violations,
+            const utils::ThresholdSum<double> &completion_times,
             const double &distance,
             const double &weight)
-            : _BaseRoute(customers, time_segments, waiting_time_violations, distance, weight) {}
+            : _BaseRoute(problem, customers, time_segments, completion_times, distance, weight) {}
 
         /**
          * @brief Construct a `TruckRoute` with pre-calculated `time_segments`, `distance` and `weight`.
          */
         TruckRoute(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments,
             const double &distance,
             const double &weight)
             : TruckRoute(
+                  problem,
                   customers,
                   time_segments,
-                  _calculate_waiting_time_violations(customers, time_segments),
+                  _calculate_completion_times(problem, customers, time_segments),
                   distance,
                   weight) {}
 
         /** @brief Construct a `TruckRoute` with pre-calculated time_segments */
         TruckRoute(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments)
             : TruckRoute(
+                  problem,
                   customers,
                   time_segments,
-                  _calculate_distance(customers),
-                  _calculate_weight(customers)) {}
+                  _calculate_distance(problem, customers),
+                  _calculate_weight(problem, customers)) {}
 
         /** @brief Construct a `TruckRoute` from a list of customers in order. */
-        TruckRoute(const std::vector<std::size_t> &customers)
-            : TruckRoute(customers, _calculate_time_segments(customers)) {}
+        TruckRoute(const Problem *problem, const std::vector<std::size_t> &customers)
+            : TruckRoute(problem, _attributes(problem, customers)) {}
 
         double capacity_violation() const override
         {
-            auto problem = Problem::get_instance();
-            return std::max(0.0, _weight - problem->truck->capacity);
+            return std::max(0.0, _weight - _problem->truck->capacity);
+        }
+
+        /**
+         * @brief Coefficients `(base, slope)` such that visiting the customers of this route in another
+         * order, changing its distance by `delta`, takes at least `base + slope * delta` working time.
+         *
+         * Service times do not depend on the order, and the truck cannot travel faster than its maximum
+         * speed.
+         *
+         * @note Time complexity `O(n)`
+         */
+        std::pair<double, double> working_time_bound() const
+        {
+            double service_time = 0;
+            for (auto &customer : _customers)
+            {
+                service_time += _problem->customer_arrays.truck_service_time[customer];
+            }
+
+            auto slope = 1.0 / _problem->truck->maximum_speed();
+            return std::make_pair(service_time + _distance * slope, slope);
+        }
+
+        /**
+         * @brief The attributes of this route after `push_back(customer)`, without modifying or
+         * copying it.
+         *
+         * @note Time complexity `O(logn)`
+         */
+        AppendProbe probe_push_back(const std::size_t &customer) const
+        {
+            auto [first, second] = _appended_time_segments(customer);
+            auto start = _working_time - _time_segments.get(_time_segments.size() - 1) + first,
+                 working_time = start + second;
+
+            return AppendProbe{
+                working_time,
+                std::max(0.0, _weight + _problem->customer_arrays.demand[customer] - _problem->truck->capacity),
+                _appended_waiting_time_violation(start + _problem->customer_arrays.truck_service_time[customer], working_time),
+                0};
         }
 
         /**
@@ -250,54 +575,26 @@ namespace d2d
          */
         void push_back(const std::size_t &customer)
         {
-            auto problem = Problem::get_instance();
+            auto problem = _problem;
+            auto [first, second] = _appended_time_segments(customer);
+
+            std::size_t old_last = _customers[_customers.size() - 2];
+            _distance += problem->distances[old_last][customer] + problem->distances[customer][0] - problem->distances[old_last][0];
+            _hash = _appended_hash(customer); // Done updating _hash
 
             _customers.back() = customer;
             _customers.push_back(0); // Done updating _customers
 
             _time_segments.pop_back();
+            _time_segments.push_back(first);
+            _time_segments.push_back(second); // Done updating _time_segments, _distance
 
-            double time_offset = _time_segments.sum();
-            std::size_t coefficients_index = time_offset / 3600.0;
-            double current_within_timespan = time_offset - 3600.0 * coefficients_index;
-
-            const auto shift = [&coefficients_index, &current_within_timespan](double *time_segment_ptr, double dt)
-            {
-                *time_segment_ptr += dt;
-                current_within_timespan += dt;
-                if (current_within_timespan >= 3600)
-                {
-                    current_within_timespan -= 3600;
-                    coefficients_index++;
-                }
-            };
+            _working_time = _time_segments.sum(); // Done updating _working_time
 
-            std::size_t old_last_index = _customers.size() - 3;
-            _distance -= problem->distances[_customers[old_last_index]][0];
+            _weight += problem->customer_arrays.demand[customer]; // Done updating _weight
 
-            for (std::size_t i = old_last_index; i + 1 < _customers.size(); i++)
-            {
-                double time_segment = 0,
-                       distance = problem->distances[_customers[i]][_customers[i + 1]];
-                shift(&time_segment, problem->customers[_customers[i]].truck_service_time);
-
-                _distance += distance;
-                while (distance > 0)
-                {
-                    double speed = problem->truck->speed(coefficients_index),
-                           distance_shift = std::min(distance, speed * (3600.0 - current_within_timespan));
-
-                    distance -= distance_shift;
-                    shift(&time_segment, distance_shift / speed);
-                }
-
-                _time_segments.push_back(time_segment);
-            } // Done updating _time_segments, _distance
-
-            _weight += problem->customers[customer].demand; // Done updating _weight
-
-            // Couldn't find a better way than recalculating it
-            _waiting_time_violations = _calculate_waiting_time_violations(_customers, _time_segments); // Done updating _waiting_time_violations
+            // Earlier customers keep their completion times, only the new customer and the depot are added
+            _update_completion_times(_customers.size() - 2, _service_time(problem)); // Done updating _completion_times, _waiting_time_violation
 
             _verify();
         }
@@ -309,13 +606,16 @@ namespace d2d
                 return;
             }
 
-            auto problem = Problem::get_instance();
+            auto problem = _problem;
 
+            _hash ^= problem->zobrist.hash(_customers, offset - 1, offset + length);
             std::reverse(_customers.begin() + offset, _customers.begin() + (offset + length)); // Done updating _customers
+            _hash ^= problem->zobrist.hash(_customers, offset - 1, offset + length); // Done updating _hash
 
             // Too lazy to implement recalculation, still O(nlogn) though.
             // Algorithm complexity doesn't even matter in the first place - typically n < 20
-            _time_segments = _calculate_time_segments(_customers); // Done updating _time_segments
+            _time_segments = _calculate_time_segments(_problem, _customers); // Done updating _time_segments
+            _working_time = _time_segments.sum();                              // Done updating _working_time
 
             _distance += problem->distances[_customers[offset - 1]][_customers[offset]] +
                          problem->distances[_customers[offset + length - 1]][_customers[offset + length]] -
@@ -324,15 +624,16 @@ namespace d2d
 
             // _weight = _weight; // Unchanged, done updating _weight
 
-            _waiting_time_violations = _calculate_waiting_time_violations(_customers, _time_segments); // Done updating _waiting_time_violations
+            _update_completion_times(offset, _service_time(problem)); // Done updating _completion_times, _waiting_time_violation
 
             _verify();
         }
     };
 
-    utils::FenwickTree<double> TruckRoute::_calculate_time_segments(const std::vector<std::size_t> &customers)
+    inline utils::FenwickTree<double> TruckRoute::_calculate_time_segments(const Problem *problem, const std::vector<std::size_t> &customers)
     {
-        auto problem = Problem::get_instance();
+        TELEMETRY_COUNT(route_rebuilds);
+
         utils::FenwickTree<double> time_segments;
 
         std::size_t coefficients_index = 0;
@@ -353,7 +654,7 @@ namespace d2d
         {
             double time_segment = 0, distance = problem->distances[customers[i]][customers[i + 1]];
 
-            shift(&time_segment, problem->customers[customers[i]].truck_service_time);
+            shift(&time_segment, problem->customer_arrays.truck_service_time[customers[i]]);
             while (distance > 0)
             {
                 double speed = problem->truck->speed(coefficients_index),
@@ -369,41 +670,125 @@ namespace d2d
         return time_segments;
     }
 
-    utils::FenwickTree<double> TruckRoute::_calculate_waiting_time_violations(
+    inline utils::ThresholdSum<double> TruckRoute::_calculate_completion_times(
+        const Problem *problem,
         const std::vector<std::size_t> &customers,
         const utils::FenwickTree<double> &time_segments)
     {
-        auto problem = Problem::get_instance();
-        return _BaseRoute::_calculate_waiting_time_violations(
-            customers,
-            time_segments,
-            [&problem](const std::size_t &customer)
-            {
-                return problem->customers[customer].truck_service_time;
-            });
+        utils::ThresholdSum<double> completion_times;
+        _extend_completion_times(customers, time_segments, _service_time(problem), completion_times);
+        return completion_times;
     }
 
     /** @brief Represents a drone route. */
     class DroneRoute : public _BaseRoute
     {
     private:
-        static utils::FenwickTree<double> _calculate_time_segments(const std::vector<std::size_t> &customers);
-        static utils::FenwickTree<double> _calculate_waiting_time_violations(
+        /** @brief The service time of customers by drone */
+        static auto _service_time(const Problem *problem)
+        {
+            return [problem](const std::size_t &customer)
+            {
+                return problem->customer_arrays.drone_service_time[customer];
+            };
+        }
+
+        static utils::FenwickTree<double> _calculate_time_segments(const Problem *problem, const std::vector<std::size_t> &customers);
+        static utils::ThresholdSum<double> _calculate_completion_times(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments);
-        static double _calculate_energy_consumption(const std::vector<std::size_t> &customers);
+        static double _calculate_energy_consumption(const Problem *problem, const std::vector<std::size_t> &customers);
+
+        /** @brief The attributes of the route `customers`, see `Problem::drone_routes_cache`. */
+        static RouteAttributes _attributes(const Problem *problem, const std::vector<std::size_t> &customers)
+        {
+            return _cached_attributes(
+                problem, customers, problem->drone_routes_cache,
+                [&problem, &customers](RouteAttributes &attributes)
+                {
+                    attributes.customers = customers;
+                    attributes.time_segments = _calculate_time_segments(problem, customers);
+                    attributes.completion_times = _calculate_completion_times(problem, customers, attributes.time_segments);
+                    attributes.distance = _calculate_distance(problem, customers);
+                    attributes.weight = _calculate_weight(problem, customers);
+                    attributes.energy_consumption = _calculate_energy_consumption(problem, customers);
+                });
+        }
+
+        DroneRoute(const Problem *problem, RouteAttributes &&attributes)
+            : _BaseRoute(problem, std::move(attributes)),
+              _energy_consumption(attributes.energy_consumption)
+        {
+            _check_dronable();
+        }
+
+        /** @brief Time segment from serving `from` to landing at `to` */
+        static double _time_segment(const Problem *problem, const std::size_t &from, const std::size_t &to)
+        {
+            auto drone = problem->drone;
+            return problem->customer_arrays.drone_service_time[from] +
+                   drone->takeoff_time() +
+                   drone->cruise_time(problem->distances[from][to]) +
+                   drone->landing_time();
+        }
+
+        /** @brief Energy consumed flying from `from` to `to` while carrying `weight` */
+        static double _leg_energy_consumption(const Problem *problem, const std::size_t &from, const std::size_t &to, const double &weight)
+        {
+            auto drone = problem->drone;
+            return drone->takeoff_time() * drone->takeoff_power(weight) +
+                   drone->cruise_time(problem->distances[from][to]) * drone->cruise_power(weight) +
+                   drone->landing_time() * drone->landing_power(weight);
+        }
+
+        static double _energy_violation(const Problem *problem, const double &energy_consumption)
+        {
+            if (problem->linear != nullptr)
+            {
+                return std::max(0.0, energy_consumption - problem->linear->battery);
+            }
+            else if (problem->nonlinear != nullptr)
+            {
+                return std::max(0.0, energy_consumption - problem->nonlinear->battery);
+            }
+
+            return 0;
+        }
 
         double _energy_consumption;
 
+        void _check_dronable() const
+        {
+#ifdef DEBUG
+            for (auto &customer : _customers)
+            {
+                if (!_problem->customer_arrays.dronable[customer])
+                {
+                    throw NonDronable(customer);
+                }
+            }
+#endif
+        }
+
     protected:
         void _verify()
         {
 #ifdef DEBUG
-            DroneRoute verify(_customers);
-            _BaseRoute::_verify<DroneRoute>(verify);
-            if (!utils::approximate(_energy_consumption, verify._energy_consumption))
+            _check_invariants();
+            if (!std::isfinite(_energy_consumption) || _energy_consumption < 0)
             {
-                throw std::runtime_error("DroneRoute::push_back: Inconsistent energy consumption, possibly an error in calculation");
+                throw std::runtime_error(utils::format("Invalid energy consumption %lf", _energy_consumption));
+            }
+
+            if (utils::debug_checks.sample())
+            {
+                DroneRoute verify(_problem, _customers);
+                _BaseRoute::_verify<DroneRoute>(verify);
+                if (!utils::approximate(_energy_consumption, verify._energy_consumption))
+                {
+                    throw std::runtime_error("DroneRoute::push_back: Inconsistent energy consumption, possibly an error in calculation");
+                }
             }
 #endif
         }
@@ -411,25 +796,17 @@ namespace d2d
     public:
         /** @brief Construct a `DroneRoute` with pre-calculated attributes. */
         DroneRoute(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments,
-            const utils::FenwickTree<double> &waiting_time_violations,
+            const utils::ThresholdSum<double> &completion_times,
             const double &distance,
             const double &weight,
             const double &energy_consumption)
-            : _BaseRoute(customers, time_segments, waiting_time_violations, distance, weight),
+            : _BaseRoute(problem, customers, time_segments, completion_times, distance, weight),
               _energy_consumption(energy_consumption)
         {
-#ifdef DEBUG
-            auto problem = Problem::get_instance();
-            for (auto &customer : customers)
-            {
-                if (!problem->customers[customer].dronable)
-                {
-                    throw NonDronable(customer);
-                }
-            }
-#endif
+            _check_dronable();
         }
 
         /**
@@ -437,38 +814,55 @@ namespace d2d
          * and `energy_consumption`.
          */
         DroneRoute(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments,
             const double &distance,
             const double &weight,
             const double &energy_consumption)
             : DroneRoute(
+                  problem,
                   customers,
                   time_segments,
-                  _calculate_waiting_time_violations(customers, time_segments),
+                  _calculate_completion_times(problem, customers, time_segments),
                   distance,
                   weight,
                   energy_consumption) {}
 
         /** @brief Construct a `DroneRoute` with pre-calculated `time_segments`. */
         DroneRoute(
+            const Problem *problem,
             const std::vector<std::size_t> &customers,
             const utils::FenwickTree<double> &time_segments)
             : DroneRoute(
+                  problem,
                   customers,
                   time_segments,
-                  _calculate_distance(customers),
-                  _calculate_weight(customers),
-                  _calculate_energy_consumption(customers)) {}
+                  _calculate_distance(problem, customers),
+                  _calculate_weight(problem, customers),
+                  _calculate_energy_consumption(problem, customers)) {}
 
         /** @brief Construct a `DroneRoute` from a list of customers in order. */
-        DroneRoute(const std::vector<std::size_t> &customers)
-            : DroneRoute(customers, _calculate_time_segments(customers)) {}
+        DroneRoute(const Problem *problem, const std::vector<std::size_t> &customers)
+            : DroneRoute(problem, _attributes(problem, customers)) {}
 
         double capacity_violation() const override
         {
-            auto problem = Problem::get_instance();
-            return std::max(0.0, _weight - problem->drone->capacity);
+            return std::max(0.0, _weight - _problem->drone->capacity);
+        }
+
+        /**
+         * @brief Coefficients `(base, slope)` such that visiting the customers of this route in another
+         * order, changing its distance by `delta`, takes at least `base + slope * delta` working time.
+         *
+         * Drone cruise time is proportional to distance and the other phases of a trip do not depend on
+         * the order, hence the bound is exact up to rounding.
+         *
+         * @note Time complexity `O(1)`
+         */
+        std::pair<double, double> working_time_bound() const
+        {
+            return std::make_pair(_working_time, _problem->drone->cruise_time(1));
         }
 
         /** @brief Total energy consumption of drone (SI unit: J) */
@@ -479,17 +873,55 @@ namespace d2d
 
         double energy_violation() const
         {
-            auto problem = Problem::get_instance();
-            if (problem->linear != nullptr)
-            {
-                return std::max(0.0, _energy_consumption - problem->linear->battery);
-            }
-            else if (problem->nonlinear != nullptr)
-            {
-                return std::max(0.0, _energy_consumption - problem->nonlinear->battery);
-            }
+            return _energy_violation(_problem, _energy_consumption);
+        }
 
-            return 0;
+        /** @brief The maximum number of customers `optimal_order` accepts */
+        static constexpr std::size_t max_optimal_customers = 10;
+
+        /**
+         * @brief The order of the customers of a drone route minimizing its working time, subject to
+         * the energy budget of the drone.
+         *
+         * Held-Karp dynamic programming over (set of served customers, last customer). The weight
+         * carried on a leg only depends on the set of customers served so far, hence so does the
+         * energy consumed on it. Each state keeps its Pareto-optimal (time, energy) labels, and labels
+         * exceeding the energy budget are discarded. Waiting time violations are not considered.
+         *
+         * @param customers The route, starting and ending at the depot, with at most
+         * `max_optimal_customers` customers
+         * @return The optimal route, or an empty vector if no order satisfies the energy budget
+         * @note Time complexity `O(2^k * k^2 * p)`, where `k` is the number of customers and `p` the
+         * number of labels per state.
+         */
+        static std::vector<std::size_t> optimal_order(const Problem *problem, const std::vector<std::size_t> &customers);
+
+        /**
+         * @brief The attributes of this route after `push_back(customer)`, without modifying or
+         * copying it.
+         *
+         * @note Time complexity `O(logn)`
+         */
+        AppendProbe probe_push_back(const std::size_t &customer) const
+        {
+            auto problem = _problem;
+            auto old_last = _customers[_customers.size() - 2];
+            auto weight = _weight + problem->customer_arrays.demand[customer];
+
+            auto first = _time_segment(problem, old_last, customer), second = _time_segment(problem, customer, 0);
+            auto start = _working_time - _time_segments.get(_time_segments.size() - 1) + first,
+                 working_time = start + second;
+
+            auto energy_consumption = _energy_consumption -
+                                      _leg_energy_consumption(problem, old_last, 0, _weight) +
+                                      _leg_energy_consumption(problem, old_last, customer, _weight) +
+                                      _leg_energy_consumption(problem, customer, 0, weight);
+
+            return AppendProbe{
+                working_time,
+                std::max(0.0, weight - problem->drone->capacity),
+                _appended_waiting_time_violation(start + problem->customer_arrays.drone_service_time[customer], working_time),
+                _energy_violation(problem, energy_consumption)};
         }
 
         /**
@@ -499,9 +931,10 @@ namespace d2d
          */
         void push_back(const std::size_t &customer)
         {
-            auto problem = Problem::get_instance();
+            auto problem = _problem;
             auto drone = problem->drone;
 
+            _hash = _appended_hash(customer); // Done updating _hash
             _customers.back() = customer;
             _customers.push_back(0); // Done updating _customers
 
@@ -513,25 +946,28 @@ namespace d2d
             _energy_consumption -= drone->takeoff_time() * drone->takeoff_power(_weight) +
                                    drone->landing_time() * drone->landing_power(_weight) +
                                    drone->cruise_time(problem->distances[_customers[old_last_index]][0]) * drone->cruise_power(_weight);
-            _weight -= problem->customers[_customers[old_last_index]].demand;
+            _weight -= problem->customer_arrays.demand[_customers[old_last_index]];
 
             for (std::size_t i = old_last_index; i + 1 < _customers.size(); i++)
             {
                 double distance = problem->distances[_customers[i]][_customers[i + 1]];
                 _time_segments.push_back(
-                    problem->customers[_customers[i]].drone_service_time +
+                    problem->customer_arrays.drone_service_time[_customers[i]] +
                     drone->takeoff_time() +
                     drone->cruise_time(distance) +
                     drone->landing_time());
 
                 _distance += distance;
-                _weight += problem->customers[_customers[i]].demand;
+                _weight += problem->customer_arrays.demand[_customers[i]];
                 _energy_consumption += drone->takeoff_time() * drone->takeoff_power(_weight) +
                                        drone->cruise_time(distance) * drone->cruise_power(_weight) +
                                        drone->landing_time() * drone->landing_power(_weight);
             } // Done updating _time_segments, _distance, _weight, _energy_consumption
 
-            _waiting_time_violations = _calculate_waiting_time_violations(_customers, _time_segments); // Done updating _waiting_time_violations
+            _working_time = _time_segments.sum(); // Done updating _working_time
+
+            // Earlier customers keep their completion times, only the new customer and the depot are added
+            _update_completion_times(_customers.size() - 2, _service_time(problem)); // Done updating _completion_times, _waiting_time_violation
 
             _verify();
         }
@@ -543,30 +979,34 @@ namespace d2d
                 return;
             }
 
-            auto problem = Problem::get_instance();
+            auto problem = _problem;
 
+            _hash ^= problem->zobrist.hash(_customers, offset - 1, offset + length);
             std::reverse(_customers.begin() + offset, _customers.begin() + (offset + length)); // Done updating _customers
+            _hash ^= problem->zobrist.hash(_customers, offset - 1, offset + length); // Done updating _hash
 
-            _time_segments = _calculate_time_segments(_customers); // Done updating _time_segments
+            _time_segments = _calculate_time_segments(_problem, _customers); // Done updating _time_segments
+            _working_time = _time_segments.sum();                              // Done updating _working_time
 
             _distance += problem->distances[_customers[offset - 1]][_customers[offset]] +
                          problem->distances[_customers[offset + length - 1]][_customers[offset + length]] -
                          problem->distances[_customers[offset - 1]][_customers[offset + length - 1]] -
                          problem->distances[_customers[offset]][_customers[offset + length]]; // Done updating _distance
 
-            _energy_consumption = _calculate_energy_consumption(_customers); // Done updating _energy_consumption
+            _energy_consumption = _calculate_energy_consumption(_problem, _customers); // Done updating _energy_consumption
 
             // _weight = _weight; // Unchanged, done updating _weight
 
-            _waiting_time_violations = _calculate_waiting_time_violations(_customers, _time_segments); // Done updating _waiting_time_violations
+            _update_completion_times(offset, _service_time(problem)); // Done updating _completion_times, _waiting_time_violation
 
             _verify();
         }
     };
 
-    utils::FenwickTree<double> DroneRoute::_calculate_time_segments(const std::vector<std::size_t> &customers)
+    inline utils::FenwickTree<double> DroneRoute::_calculate_time_segments(const Problem *problem, const std::vector<std::size_t> &customers)
     {
-        auto problem = Problem::get_instance();
+        TELEMETRY_COUNT(route_rebuilds);
+
         utils::FenwickTree<double> time_segments;
 
         auto drone = problem->drone;
@@ -574,7 +1014,7 @@ namespace d2d
         for (std::size_t i = 0; i + 1 < customers.size(); i++)
         {
             time_segments.push_back(
-                problem->customers[customers[i]].drone_service_time +
+                problem->customer_arrays.drone_service_time[customers[i]] +
                 drone->takeoff_time() +
                 drone->cruise_time(problem->distances[customers[i]][customers[i + 1]]) +
                 drone->landing_time());
@@ -583,29 +1023,24 @@ namespace d2d
         return time_segments;
     }
 
-    utils::FenwickTree<double> DroneRoute::_calculate_waiting_time_violations(
+    inline utils::ThresholdSum<double> DroneRoute::_calculate_completion_times(
+        const Problem *problem,
         const std::vector<std::size_t> &customers,
         const utils::FenwickTree<double> &time_segments)
     {
-        auto problem = Problem::get_instance();
-        return _BaseRoute::_calculate_waiting_time_violations(
-            customers,
-            time_segments,
-            [&problem](const std::size_t &customer)
-            {
-                return problem->customers[customer].drone_service_time;
-            });
+        utils::ThresholdSum<double> completion_times;
+        _extend_completion_times(customers, time_segments, _service_time(problem), completion_times);
+        return completion_times;
     }
 
-    double DroneRoute::_calculate_energy_consumption(const std::vector<std::size_t> &customers)
+    inline double DroneRoute::_calculate_energy_consumption(const Problem *problem, const std::vector<std::size_t> &customers)
     {
-        auto problem = Problem::get_instance();
         double energy = 0, weight = 0;
 
         auto drone = problem->drone;
         for (std::size_t i = 0; i + 1 < customers.size(); i++)
         {
-            weight += problem->customers[customers[i]].demand;
+            weight += problem->customer_arrays.demand[customers[i]];
             energy += drone->takeoff_time() * drone->takeoff_power(weight) +
                       drone->cruise_time(problem->distances[customers[i]][customers[i + 1]]) * drone->cruise_power(weight) +
                       drone->landing_time() * drone->landing_power(weight);
@@ -613,11 +1048,191 @@ namespace d2d
 
         return energy;
     }
+
+    inline std::vector<std::size_t> DroneRoute::optimal_order(const Problem *problem, const std::vector<std::size_t> &customers)
+    {
+        std::size_t k = customers.size() - 2;
+        if (k > max_optimal_customers)
+        {
+            throw std::invalid_argument(utils::format("Cannot optimize a drone route of %lu customers", k));
+        }
+
+        struct _Label
+        {
+            double time, energy;
+
+            /** @brief The previous customer (index in the route), and the index of its label */
+            std::size_t previous, label;
+        };
+
+        std::vector<double> weights(1 << k);
+        for (std::size_t mask = 1; mask < weights.size(); mask++)
+        {
+            auto low = std::countr_zero(mask);
+            weights[mask] = weights[mask & (mask - 1)] + problem->customer_arrays.demand[customers[low + 1]];
+        }
+
+        // labels[mask][last] are the labels of routes serving the customers in `mask`, ending at `last`
+        std::vector<std::vector<std::vector<_Label>>> labels(1 << k, std::vector<std::vector<_Label>>(k));
+        const auto push = [&labels](const std::size_t &mask, const std::size_t &last, const _Label &label)
+        {
+            auto &front = labels[mask][last];
+            for (auto &other : front)
+            {
+                if (other.time <= label.time && other.energy <= label.energy)
+                {
+                    return;
+                }
+            }
+
+            front.erase(
+                std::remove_if(
+                    front.begin(), front.end(),
+                    [&label](const _Label &other)
+                    {
+                        return label.time <= other.time && label.energy <= other.energy;
+                    }),
+                front.end());
+            front.push_back(label);
+        };
+
+        for (std::size_t i = 0; i < k; i++)
+        {
+            auto energy = _leg_energy_consumption(problem, 0, customers[i + 1], 0);
+            if (_energy_violation(problem, energy) == 0)
+            {
+                push(1 << i, i, _Label{_time_segment(problem, 0, customers[i + 1]), energy, k, 0});
+            }
+        }
+
+        for (std::size_t mask = 1; mask < labels.size(); mask++)
+        {
+            for (std::size_t last = 0; last < k; last++)
+            {
+                for (std::size_t label = 0; label < labels[mask][last].size(); label++)
+                {
+                    auto current = labels[mask][last][label];
+                    for (std::size_t next = 0; next < k; next++)
+                    {
+                        if (mask & (1 << next))
+                        {
+                            continue;
+                        }
+
+                        auto energy = current.energy + _leg_energy_consumption(problem, customers[last + 1], customers[next + 1], weights[mask]);
+                        if (_energy_violation(problem, energy) == 0)
+                        {
+                            push(
+                                mask | (1 << next), next,
+                                _Label{current.time + _time_segment(problem, customers[last + 1], customers[next + 1]), energy, last, label});
+                        }
+                    }
+                }
+            }
+        }
+
+        // Close the route at the depot and pick the fastest feasible label
+        std::size_t full = (1 << k) - 1, best_last = k, best_label = 0;
+        double best_time = std::numeric_limits<double>::infinity();
+        for (std::size_t last = 0; last < k; last++)
+        {
+            for (std::size_t label = 0; label < labels[full][last].size(); label++)
+            {
+                auto &current = labels[full][last][label];
+                auto energy = current.energy + _leg_energy_consumption(problem, customers[last + 1], 0, weights[full]);
+                auto time = current.time + _time_segment(problem, customers[last + 1], 0);
+                if (_energy_violation(problem, energy) == 0 && time < best_time)
+                {
+                    best_time = time;
+                    best_last = last;
+                    best_label = label;
+                }
+            }
+        }
+
+        if (best_last == k)
+        {
+            return {};
+        }
+
+        std::vector<std::size_t> result(customers.size());
+        std::size_t mask = full, last = best_last, label = best_label;
+        for (std::size_t position = k; position > 0; position--)
+        {
+            result[position] = customers[last + 1];
+
+            auto &current = labels[mask][last][label];
+            mask ^= 1 << last;
+            last = current.previous;
+            label = current.label;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Memoized `DroneRoute::optimal_order`, keyed by the set of customers of a route.
+     *
+     * The same sets of customers are evaluated many times during a search, each is optimized only
+     * once. Not thread-safe, each search owns its cache.
+     */
+    class OptimalDroneOrders
+    {
+    private:
+        struct _Hash
+        {
+            std::size_t operator()(const std::vector<std::size_t> &customers) const
+            {
+                std::uint64_t hash = 0xcbf29ce484222325ull;
+                for (auto &customer : customers)
+                {
+                    hash = (hash ^ customer) * 0x100000001b3ull;
+                }
+
+                return hash;
+            }
+        };
+
+        /** @brief The cache is cleared once it reaches this many entries */
+        static constexpr std::size_t _max_size = 1 << 16;
+
+        const Problem *_problem;
+        std::unordered_map<std::vector<std::size_t>, std::vector<std::size_t>, _Hash> _orders;
+
+    public:
+        OptimalDroneOrders(const Problem *problem) : _problem(problem) {}
+
+        /**
+         * @brief The optimal order of the customers of a drone route, see `DroneRoute::optimal_order`.
+         * @return The optimal route, or an empty vector if no order satisfies the energy budget
+         */
+        const std::vector<std::size_t> &get(const std::vector<std::size_t> &customers)
+        {
+            std::vector<std::size_t> key(customers.begin() + 1, customers.end() - 1);
+            std::sort(key.begin(), key.end());
+
+            auto iter = _orders.find(key);
+            if (iter == _orders.end())
+            {
+                if (_orders.size() >= _max_size)
+                {
+                    _orders.clear();
+                }
+
+                std::vector<std::size_t> route{0};
+                route.insert(route.end(), key.begin(), key.end());
+                route.push_back(0);
+                iter = _orders.emplace(std::move(key), DroneRoute::optimal_order(_problem, route)).first;
+            }
+
+            return iter->second;
+        }
+    };
 }
 
 namespace std
 {
-    ostream &operator<<(ostream &stream, const d2d::_BaseRoute &route)
+    inline ostream &operator<<(ostream &stream, const d2d::_BaseRoute &route)
     {
         return stream << route.customers();
     }
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "checks.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace utils
+{
+    /** @brief The instruction sets a kernel may be dispatched to, in increasing order of width. */
+    enum class SimdLevel
+    {
+        scalar,
+        avx2,
+        avx512
+    };
+
+    /** @brief The widest instruction set supported by the running CPU, detected once. */
+    inline SimdLevel simd_level()
+    {
+#if defined(__GNUC__) && defined(__x86_64__)
+        static const SimdLevel level = []()
+        {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+            {
+                return SimdLevel::avx512;
+            }
+
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return SimdLevel::avx2;
+            }
+
+            return SimdLevel::scalar;
+        }();
+
+        return level;
+#else
+        return SimdLevel::scalar;
+#endif
+    }
+
+    inline void _gather_deltas_scalar(
+        const double *first,
+        const double *second,
+        const std::size_t *indices,
+        const double *offsets,
+        double *out,
+        const std::size_t &count)
+    {
+        for (std::size_t k = 0; k < count; k++)
+        {
+            out[k] = first[indices[k]] + second[indices[k + 1]] - offsets[k];
+        }
+    }
+
+#if defined(__GNUC__) && defined(__x86_64__)
+    __attribute__((target("avx2"))) inline void _gather_deltas_avx2(
+        const double *first,
+        const double *second,
+        const std::size_t *indices,
+        const double *offsets,
+        double *out,
+        const std::size_t &count)
+    {
+        std::size_t k = 0;
+        for (; k + 4 <= count; k += 4)
+        {
+            auto current = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + k)),
+                 next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + k + 1));
+
+            auto sum = _mm256_add_pd(_mm256_i64gather_pd(first, current, 8), _mm256_i64gather_pd(second, next, 8));
+            _mm256_storeu_pd(out + k, _mm256_sub_pd(sum, _mm256_loadu_pd(offsets + k)));
+        }
+
+        _gather_deltas_scalar(first, second, indices + k, offsets + k, out + k, count - k);
+    }
+
+    __attribute__((target("avx512f"))) inline void _gather_deltas_avx512(
+        const double *first,
+        const double *second,
+        const std::size_t *indices,
+        const double *offsets,
+        double *out,
+        const std::size_t &count)
+    {
+        std::size_t k = 0;
+        for (; k + 8 <= count; k += 8)
+        {
+            auto current = _mm512_loadu_si512(indices + k),
+                 next = _mm512_loadu_si512(indices + k + 1);
+
+            // Masked gathers with a defined source, the unmasked ones trigger false -Wmaybe-uninitialized
+            auto zero = _mm512_setzero_pd();
+            auto sum = _mm512_add_pd(
+                _mm512_mask_i64gather_pd(zero, 0xff, current, first, 8),
+                _mm512_mask_i64gather_pd(zero, 0xff, next, second, 8));
+            _mm512_storeu_pd(out + k, _mm512_sub_pd(sum, _mm512_loadu_pd(offsets + k)));
+        }
+
+        _gather_deltas_avx2(first, second, indices + k, offsets + k, out + k, count - k);
+    }
+#endif
+
+    /**
+     * @brief Compute `out[k] = first[indices[k]] + second[indices[k + 1]] - offsets[k]` for `k` in
+     * `[0, count)`, gathering from `first` and `second` with the widest instructions supported by the
+     * running CPU.
+     *
+     * @param indices An array of `count + 1` indices
+     * @note The result does not depend on the instruction set: each element is computed with the
+     * same operations in the same order.
+     */
+    inline void gather_deltas(
+        const double *first,
+        const double *second,
+        const std::size_t *indices,
+        const double *offsets,
+        double *out,
+        const std::size_t &count)
+    {
+        switch (simd_level())
+        {
+#if defined(__GNUC__) && defined(__x86_64__)
+        case SimdLevel::avx512:
+            _gather_deltas_avx512(first, second, indices, offsets, out, count);
+            break;
+
+        case SimdLevel::avx2:
+            _gather_deltas_avx2(first, second, indices, offsets, out, count);
+            break;
+#endif
+
+        default:
+            _gather_deltas_scalar(first, second, indices, offsets, out, count);
+            break;
+        }
+
+#ifdef DEBUG
+        if (debug_checks.sample())
+        {
+            std::vector<double> verify(count);
+            _gather_deltas_scalar(first, second, indices, offsets, verify.data(), count);
+            if (!std::equal(verify.begin(), verify.end(), out))
+            {
+                throw std::runtime_error("Inconsistent vectorized deltas, possibly an error in a SIMD kernel");
+            }
+        }
+#endif
+    }
+}
@@ -2,9 +2,14 @@
 
 #include "initial.hpp"
 #include "problem.hpp"
+#include "progress.hpp"
 #include "random.hpp"
 #include "routes.hpp"
+#include "timings.hpp"
+#include "trace.hpp"
+#include "neighborhoods/cross_exchange.hpp"
 #include "neighborhoods/move_xy.hpp"
+#include "neighborhoods/ruin_recreate.hpp"
 #include "neighborhoods/two_opt.hpp"
 
 namespace d2d
@@ -13,7 +18,9 @@ namespace d2d
     class Solution
     {
     private:
-        static const std::vector<std::shared_ptr<Neighborhood<Solution>>> neighborhoods;
+        /** @brief The neighborhoods explored by tabu search, dispatched statically via `utils::visit_at` */
+        using _neighborhoods_t = std::tuple<MoveXY<Solution, 2, 1>, TwoOpt<Solution>, RuinRecreate<Solution>, CrossExchange<Solution, 3>>;
+
         static double _calculate_working_time(
             const std::vector<std::vector<TruckRoute>> &truck_routes,
             const std::vector<std::vector<DroneRoute>> &drone_routes);
@@ -21,8 +28,18 @@ namespace d2d
         static double _calculate_capacity_violation(
             const std::vector<std::vector<TruckRoute>> &truck_routes,
             const std::vector<std::vector<DroneRoute>> &drone_routes);
+        static double _calculate_waiting_time_violation(
+            const std::vector<std::vector<TruckRoute>> &truck_routes,
+            const std::vector<std::vector<DroneRoute>> &drone_routes);
+
+#ifdef TELEMETRY
+        static void _report_telemetry(const _neighborhoods_t &neighborhoods, const utils::Telemetry &telemetry);
+#endif
 
     public:
+        /** @brief The problem context this solution belongs to */
+        const Problem *const problem;
+
         /** @brief System working time */
         const double working_time;
 
@@ -32,6 +49,9 @@ namespace d2d
         /** @brief Total capacity violation */
         const double capacity_violation;
 
+        /** @brief Total waiting time violation */
+        const double waiting_time_violation;
+
         /** @brief Routes of trucks */
         const std::vector<std::vector<TruckRoute>> truck_routes;
 
@@ -39,16 +59,30 @@ namespace d2d
         const std::vector<std::vector<DroneRoute>> drone_routes;
 
         Solution(
+            const Problem *problem,
             const std::vector<std::vector<TruckRoute>> &truck_routes,
             const std::vector<std::vector<DroneRoute>> &drone_routes)
-            : working_time(_calculate_working_time(truck_routes, drone_routes)),
+            : problem(problem),
+              working_time(_calculate_working_time(truck_routes, drone_routes)),
               drone_energy_violation(_calculate_energy_violation(drone_routes)),
               capacity_violation(_calculate_capacity_violation(truck_routes, drone_routes)),
+              waiting_time_violation(_calculate_waiting_time_violation(truck_routes, drone_routes)),
               truck_routes(truck_routes),
               drone_routes(drone_routes)
         {
+            TELEMETRY_COUNT(solution_constructions);
+
 #ifdef DEBUG
-            auto problem = Problem::get_instance();
+            if (!std::isfinite(working_time) || drone_energy_violation < 0 || capacity_violation < 0 || waiting_time_violation < 0)
+            {
+                throw std::runtime_error("Invalid working time or violations, possibly an error in calculation");
+            }
+
+            if (!utils::debug_checks.sample())
+            {
+                return;
+            }
+
             std::vector<bool> exists(problem->customers.size());
 
 #define CHECK_ROUTES(vehicle_routes)                                                                             \
@@ -89,16 +123,39 @@ namespace d2d
             return working_time;
         }
 
-        static std::shared_ptr<Solution> initial();
+        /** @brief Whether all drone energy, capacity and waiting time constraints are satisfied. */
+        bool feasible() const
+        {
+            return drone_energy_violation == 0 && capacity_violation == 0 && waiting_time_violation == 0;
+        }
+
+        /**
+         * @param timings If not `nullptr`, records the duration of each initial heuristic
+         */
+        static std::shared_ptr<Solution> initial(const Problem *problem, utils::PhaseTimings *timings = nullptr);
         static std::shared_ptr<Solution> post_optimization(const std::shared_ptr<Solution> &solution);
+
+        /**
+         * @param timings If not `nullptr`, records the duration of the initial heuristics, the tabu
+         * search and the post-optimization
+         * @param history If not `nullptr`, records `(seconds since the start, best cost)` for the
+         * initial solution and every later improvement
+         * @param trace If not `nullptr`, receives a record of every iteration
+         * @param progress If not `nullptr`, receives the progress of the search. Otherwise, a terminal
+         * progress bar is shown in verbose mode.
+         */
+        static std::shared_ptr<Solution> tabu_search(
+            const Problem *problem,
+            utils::PhaseTimings *timings = nullptr,
+            std::vector<std::pair<double, double>> *history = nullptr,
+            utils::ConvergenceTrace *trace = nullptr,
+            utils::ProgressReporter *progress = nullptr);
+
+        /** @brief Compatibility wrapper solving the problem returned by `Problem::get_instance` */
         static std::shared_ptr<Solution> tabu_search();
     };
 
-    const std::vector<std::shared_ptr<Neighborhood<Solution>>> Solution::neighborhoods = {
-        std::make_shared<MoveXY<Solution, 2, 1>>(),
-        std::make_shared<TwoOpt<Solution>>()};
-
-    double Solution::_calculate_working_time(
+    inline double Solution::_calculate_working_time(
         const std::vector<std::vector<TruckRoute>> &truck_routes,
         const std::vector<std::vector<DroneRoute>> &drone_routes)
     {
@@ -123,7 +180,7 @@ namespace d2d
         return result;
     }
 
-    double Solution::_calculate_energy_violation(const std::vector<std::vector<DroneRoute>> &drone_routes)
+    inline double Solution::_calculate_energy_violation(const std::vector<std::vector<DroneRoute>> &drone_routes)
     {
         double result = 0;
         for (auto &routes : drone_routes)
@@ -137,7 +194,7 @@ namespace d2d
         return result;
     }
 
-    double Solution::_calculate_capacity_violation(
+    inline double Solution::_calculate_capacity_violation(
         const std::vector<std::vector<TruckRoute>> &truck_routes,
         const std::vector<std::vector<DroneRoute>> &drone_routes)
     {
@@ -159,74 +216,249 @@ namespace d2d
         return result;
     }
 
-    std::shared_ptr<Solution> Solution::initial()
+    inline double Solution::_calculate_waiting_time_violation(
+        const std::vector<std::vector<TruckRoute>> &truck_routes,
+        const std::vector<std::vector<DroneRoute>> &drone_routes)
+    {
+        double result = 0;
+
+#define CALCULATE_D2D_ROUTES(vehicle_routes)          \
+    for (auto &routes : vehicle_routes)               \
+    {                                                 \
+        for (auto &route : routes)                    \
+        {                                             \
+            result += route.waiting_time_violation(); \
+        }                                             \
+    }
+
+        CALCULATE_D2D_ROUTES(truck_routes);
+        CALCULATE_D2D_ROUTES(drone_routes);
+#undef CALCULATE_D2D_ROUTES
+
+        return result;
+    }
+
+#ifdef TELEMETRY
+    inline void Solution::_report_telemetry(const _neighborhoods_t &neighborhoods, const utils::Telemetry &telemetry)
     {
-        auto result = initial_12(true);
-        auto r = initial_12(false);
+        // Build the report first so that concurrent searches do not interleave their lines
+        std::string report = "Telemetry:";
+        for (std::size_t i = 0; i < std::tuple_size_v<_neighborhoods_t>; i++)
+        {
+            utils::visit_at(
+                neighborhoods,
+                i,
+                [&report, &telemetry, &i](const auto &neighborhood)
+                {
+                    report += utils::format(
+                        " candidates[%s]=%lu pruned_candidates[%s]=%lu",
+                        neighborhood.label().c_str(), telemetry.candidates[i],
+                        neighborhood.label().c_str(), telemetry.pruned_candidates[i]);
+                });
+        }
+
+        report += utils::format(
+            " route_rebuilds=%lu route_cache_hits=%lu solution_constructions=%lu tabu_rejections=%lu aspiration_overrides=%lu improvements=%lu\n",
+            telemetry.route_rebuilds,
+            telemetry.route_cache_hits,
+            telemetry.solution_constructions,
+            telemetry.tabu_rejections,
+            telemetry.aspiration_overrides,
+            telemetry.improvements);
+
+        std::cerr << report << std::flush;
+    }
+#endif
+
+    inline std::shared_ptr<Solution> Solution::initial(const Problem *problem, utils::PhaseTimings *timings)
+    {
+        auto result = utils::PhaseTimings::measure(
+            timings,
+            "initial_1",
+            [problem]()
+            {
+                return initial_12(problem, true);
+            });
+        auto r = utils::PhaseTimings::measure(
+            timings,
+            "initial_2",
+            [problem]()
+            {
+                return initial_12(problem, false);
+            });
         result = result->cost() < r->cost() ? result : r;
 
-        r = initial_3();
+        r = utils::PhaseTimings::measure(
+            timings,
+            "initial_3",
+            [problem]()
+            {
+                return initial_3(problem);
+            });
+        result = result->cost() < r->cost() ? result : r;
+
+        r = utils::PhaseTimings::measure(
+            timings,
+            "initial_split",
+            [problem]()
+            {
+                return initial_split(problem);
+            });
+        result = result->cost() < r->cost() ? result : r;
+
+        r = utils::PhaseTimings::measure(
+            timings,
+            "initial_savings",
+            [problem]()
+            {
+                return initial_savings(problem);
+            });
+        result = result->cost() < r->cost() ? result : r;
+
+        r = utils::PhaseTimings::measure(
+            timings,
+            "initial_regret",
+            [problem]()
+            {
+                return initial_regret(problem);
+            });
         result = result->cost() < r->cost() ? result : r;
 
         return result;
     }
 
-    std::shared_ptr<Solution> Solution::post_optimization(const std::shared_ptr<Solution> &solution)
+    inline std::shared_ptr<Solution> Solution::post_optimization(const std::shared_ptr<Solution> &solution)
     {
         return solution;
     }
 
-    std::shared_ptr<Solution> Solution::tabu_search()
+    inline std::shared_ptr<Solution> Solution::tabu_search()
     {
-        auto problem = Problem::get_instance();
-        auto current = initial(), result = current;
+        return tabu_search(Problem::get_instance());
+    }
+
+    inline std::shared_ptr<Solution> Solution::tabu_search(
+        const Problem *problem,
+        utils::PhaseTimings *timings,
+        std::vector<std::pair<double, double>> *history,
+        utils::ConvergenceTrace *trace,
+        utils::ProgressReporter *progress)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        const auto improved = [&begin, history](const Solution &solution)
+        {
+            if (history != nullptr)
+            {
+                history->emplace_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(), solution.cost());
+            }
+        };
+
+#ifdef TELEMETRY
+        static_assert(std::tuple_size_v<_neighborhoods_t> <= utils::Telemetry::max_neighborhoods);
+        auto telemetry_begin = utils::telemetry;
+#endif
+
+        auto current = initial(problem, timings), result = current;
+        improved(*result);
+
+        auto start = std::chrono::steady_clock::now();
+        _neighborhoods_t neighborhoods{MoveXY<Solution, 2, 1>(problem), TwoOpt<Solution>(problem), RuinRecreate<Solution>(problem), CrossExchange<Solution, 3>(problem)};
 
         const auto aspiration_criteria = [&result](const Solution &s)
         {
             return s.cost() < result->cost();
         };
 
-        for (std::size_t iteration = 0; iteration < problem->iterations; iteration++)
+        if (trace != nullptr)
         {
-            if (problem->verbose)
-            {
-                auto prefix = utils::format("Iteration #%lu/%lu(%.2lf) ", iteration + 1, problem->iterations, result->cost());
-                std::cout << prefix;
-                try
+            std::vector<std::string> labels;
+            std::apply(
+                [&labels](const auto &...neighborhood)
                 {
-                    auto width = utils::get_console_size().first;
-                    const std::size_t excess = 10;
-                    if (prefix.size() + excess < width)
-                    {
-                        auto total = width - prefix.size() - excess,
-                             cover = (iteration * total + problem->iterations - 1) / problem->iterations;
-                        std::cout << '[' << std::string(cover, '#') << std::string(total - cover, ' ') << ']';
-                    }
-                }
-                catch (std::runtime_error &)
+                    (labels.push_back(neighborhood.label()), ...);
+                },
+                neighborhoods);
+            trace->set_labels(labels);
+        }
+
+        std::unique_ptr<utils::ProgressReporter> default_progress;
+        if (progress == nullptr && problem->verbose)
+        {
+            default_progress = std::make_unique<utils::ProgressReporter>(utils::ProgressFormat::terminal, problem->iterations);
+            progress = default_progress.get();
+        }
+
+        for (std::size_t iteration = 0; iteration < problem->iterations; iteration++)
+        {
+            std::shared_ptr<Solution> neighbor;
+            auto neighborhood_index = utils::random(static_cast<std::size_t>(0), std::tuple_size_v<_neighborhoods_t> - 1);
+#ifdef TELEMETRY
+            utils::telemetry.neighborhood = neighborhood_index;
+#endif
+
+            utils::visit_at(
+                neighborhoods,
+                neighborhood_index,
+                [&neighbor, &current, &aspiration_criteria](auto &neighborhood)
                 {
-                    // pass
-                }
-                std::cout << '\r' << std::flush;
-            }
+                    neighbor = neighborhood.move(current, aspiration_criteria);
+                });
 
-            auto neighborhood = utils::random_element(neighborhoods);
-            auto neighbor = neighborhood->move(current, aspiration_criteria);
             if (neighbor != nullptr)
             {
                 current = neighbor;
                 if (neighbor->cost() < result->cost())
                 {
                     result = neighbor;
+                    improved(*result);
+                    TELEMETRY_COUNT(improvements);
                 }
             }
+
+            if (trace != nullptr)
+            {
+                std::pair<std::size_t, std::size_t> move;
+                utils::visit_at(
+                    neighborhoods,
+                    neighborhood_index,
+                    [&move](const auto &neighborhood)
+                    {
+                        move = neighborhood.last_move();
+                    });
+
+                trace->record(
+                    {std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(),
+                     iteration,
+                     current->cost(),
+                     result->cost(),
+                     neighborhood_index,
+                     move.first,
+                     move.second});
+            }
+
+            if (progress != nullptr)
+            {
+                progress->update(iteration + 1, result->cost());
+            }
         }
 
-        if (problem->verbose)
+        default_progress.reset(); // Print the final state before returning
+
+#ifdef TELEMETRY
+        _report_telemetry(neighborhoods, utils::telemetry - telemetry_begin);
+#endif
+
+        if (timings != nullptr)
         {
-            std::cout << std::endl;
+            timings->record("tabu_search", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
         }
 
-        return post_optimization(result);
+        return utils::PhaseTimings::measure(
+            timings,
+            "post_optimization",
+            [&result]()
+            {
+                return post_optimization(result);
+            });
     }
 }
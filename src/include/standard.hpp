@@ -1,17 +1,36 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <charconv>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <limits>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <optional>
+#include <queue>
 #include <random>
 #include <set>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #if defined(_WIN32) && !defined(WIN32)
@@ -21,8 +40,11 @@
 #if defined(WIN32)
 #include <windows.h>
 #elif defined(__linux__)
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 namespace std
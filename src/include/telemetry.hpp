@@ -0,0 +1,77 @@
+#pragma once
+
+#include "standard.hpp"
+
+/**
+ * @brief Increment a field of `utils::telemetry`, compiled out unless `TELEMETRY` is defined.
+ */
+#ifdef TELEMETRY
+#define TELEMETRY_COUNT(counter) (utils::telemetry.counter++)
+#else
+#define TELEMETRY_COUNT(counter)
+#endif
+
+namespace utils
+{
+    /** @brief Counters of the search hot paths. */
+    class Telemetry
+    {
+    public:
+        static constexpr std::size_t max_neighborhoods = 8;
+
+        /** @brief Index of the neighborhood currently being explored */
+        std::size_t neighborhood = 0;
+
+        /** @brief Candidate solutions constructed and evaluated, per neighborhood */
+        std::array<std::size_t, max_neighborhoods> candidates{};
+
+        /** @brief Candidates skipped without construction because they cannot improve, per neighborhood */
+        std::array<std::size_t, max_neighborhoods> pruned_candidates{};
+
+        /** @brief Route time segments calculated from scratch */
+        std::size_t route_rebuilds = 0;
+
+        /** @brief Routes built from cached attributes instead of from scratch */
+        std::size_t route_cache_hits = 0;
+
+        /** @brief Solution objects constructed, including initial and rejected candidates */
+        std::size_t solution_constructions = 0;
+
+        /** @brief Candidates discarded because their move is tabu */
+        std::size_t tabu_rejections = 0;
+
+        /** @brief Tabu candidates accepted because they satisfy the aspiration criteria */
+        std::size_t aspiration_overrides = 0;
+
+        /** @brief Improvements of the best solution */
+        std::size_t improvements = 0;
+
+        /** @brief The counts accumulated since the snapshot `other`. */
+        Telemetry operator-(const Telemetry &other) const
+        {
+            Telemetry result;
+            for (std::size_t i = 0; i < max_neighborhoods; i++)
+            {
+                result.candidates[i] = candidates[i] - other.candidates[i];
+                result.pruned_candidates[i] = pruned_candidates[i] - other.pruned_candidates[i];
+            }
+
+            result.route_rebuilds = route_rebuilds - other.route_rebuilds;
+            result.route_cache_hits = route_cache_hits - other.route_cache_hits;
+            result.solution_constructions = solution_constructions - other.solution_constructions;
+            result.tabu_rejections = tabu_rejections - other.tabu_rejections;
+            result.aspiration_overrides = aspiration_overrides - other.aspiration_overrides;
+            result.improvements = improvements - other.improvements;
+            return result;
+        }
+    };
+
+#ifdef TELEMETRY
+    /**
+     * @brief The counters of the current thread, so that increments never contend. A search runs
+     * on a single thread, hence the difference of two snapshots taken by that thread is exactly the
+     * work of that search.
+     */
+    inline thread_local Telemetry telemetry;
+#endif
+}
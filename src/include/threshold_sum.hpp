@@ -0,0 +1,113 @@
+#pragma once
+
+#include "utils.hpp"
+
+namespace utils
+{
+    /**
+     * @brief A nondecreasing sequence of keys answering `sum(max(0, x - key))` for any threshold `x`.
+     *
+     * Keys below a threshold form a prefix of the sequence, hence a query is a binary search
+     * followed by a lookup in the prefix sums of the keys.
+     *
+     * @tparam T An arithmetic type
+     */
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, bool> = true>
+    class ThresholdSum
+    {
+    private:
+        std::vector<T> _keys;
+
+        // Prefix sums of `_keys`, its size is always `_keys.size() + 1`
+        std::vector<T> _prefix;
+
+    public:
+        /**
+         * @brief Construct an empty sequence.
+         * @note Time complexity `O(1)`
+         */
+        ThresholdSum() : _prefix{static_cast<T>(0)} {}
+
+        /** @brief The underlying keys, in nondecreasing order */
+        const std::vector<T> &keys() const
+        {
+            return _keys;
+        }
+
+        /** @brief Get the number of keys */
+        std::size_t size() const
+        {
+            return _keys.size();
+        }
+
+        /**
+         * @brief Calculate the sum of `x - key` over all keys less than `x`.
+         *
+         * @param x The threshold
+         * @note Time complexity `O(logn)`, where `n` is the number of keys.
+         */
+        T sum_below(const T &x) const
+        {
+            return sum_below(x, _keys.size());
+        }
+
+        /**
+         * @brief Calculate the sum of `x - key` over the first `size` keys less than `x`.
+         *
+         * @param x The threshold
+         * @param size The number of leading keys to consider
+         * @note Time complexity `O(logn)`, where `n` is the number of keys.
+         */
+        T sum_below(const T &x, const std::size_t &size) const
+        {
+            auto count = std::lower_bound(_keys.begin(), _keys.begin() + size, x) - _keys.begin();
+            return std::max(static_cast<T>(0), static_cast<T>(count) * x - _prefix[count]);
+        }
+
+        /** @brief Attempt to preallocate enough memory for specified number of keys. */
+        void reserve(const std::size_t &size)
+        {
+            _keys.reserve(size);
+            _prefix.reserve(size + 1);
+        }
+
+        /**
+         * @brief Append a key, which must not be less than the last one.
+         *
+         * @param key The key to append
+         * @note Time complexity `O(1)` amortized
+         */
+        void push_back(const T &key)
+        {
+            _keys.push_back(key);
+            _prefix.push_back(_prefix.back() + key);
+        }
+
+        /**
+         * @brief Remove the last key. No data is returned.
+         */
+        void pop_back()
+        {
+            if (_keys.empty())
+            {
+                throw std::out_of_range("Cannot pop from an empty ThresholdSum");
+            }
+
+            _keys.pop_back();
+            _prefix.pop_back();
+        }
+
+        /**
+         * @brief Keep the first `size` keys only.
+         * @note Time complexity `O(1)`
+         */
+        void truncate(const std::size_t &size)
+        {
+            if (size < _keys.size())
+            {
+                _keys.resize(size);
+                _prefix.resize(size + 1);
+            }
+        }
+    };
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "standard.hpp"
+
+namespace utils
+{
+    /** @brief Wall-clock durations of the named phases of a run, in execution order. */
+    class PhaseTimings
+    {
+    private:
+        std::vector<std::pair<std::string, double>> _phases;
+
+    public:
+        const std::vector<std::pair<std::string, double>> &phases() const
+        {
+            return _phases;
+        }
+
+        void record(const std::string &name, const double &seconds)
+        {
+            _phases.emplace_back(name, seconds);
+        }
+
+        /**
+         * @brief Run `function` and record its duration under `name`.
+         *
+         * @param timings The recorder, or `nullptr` to only run `function`
+         * @return The result of `function`
+         */
+        template <typename _Function>
+        static auto measure(PhaseTimings *timings, const std::string &name, _Function &&function)
+        {
+            if (timings == nullptr)
+            {
+                return function();
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            const auto finish = [timings, &name, &start]()
+            {
+                timings->record(name, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            };
+
+            if constexpr (std::is_void_v<decltype(function())>)
+            {
+                function();
+                finish();
+            }
+            else
+            {
+                auto result = function();
+                finish();
+                return result;
+            }
+        }
+    };
+}
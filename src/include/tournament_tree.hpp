@@ -0,0 +1,92 @@
+#pragma once
+
+#include "utils.hpp"
+
+namespace utils
+{
+    /**
+     * @brief A fixed-size array maintaining its maximum element, implemented as a
+     * [tournament tree](https://en.wikipedia.org/wiki/K-way_merge_algorithm#Tournament_Tree).
+     *
+     * Leaves are stored at `[n, 2n)` and each internal node `i` holds the winner of its children
+     * `2i` and `2i + 1`, hence the root `1` holds the maximum of the whole array.
+     *
+     * @tparam T An arithmetic type
+     */
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, bool> = true>
+    class TournamentTree
+    {
+    private:
+        std::size_t _size;
+
+        // The tree representation, its size is always `max(2 * _size, 2)`
+        std::vector<T> _tree;
+
+    public:
+        /**
+         * @brief Construct a new TournamentTree object from the range [begin, end).
+         *
+         * @param begin An iterator to the beginning of the range
+         * @param end An iterator past the end of the range
+         * @note Time complexity `O(n)`, where `n` is the number of elements between `begin` and `end`.
+         */
+        template <typename _InputIterator, is_input_iterator_t<_InputIterator> = true>
+        TournamentTree(const _InputIterator &begin, const _InputIterator &end)
+        {
+            std::vector<T> array(begin, end);
+            _size = array.size();
+            _tree.resize(std::max<std::size_t>(2 * _size, 2), std::numeric_limits<T>::lowest());
+
+            std::copy(array.begin(), array.end(), _tree.begin() + _size);
+            for (std::size_t i = _size; i > 1; i--)
+            {
+                _tree[i - 1] = std::max(_tree[2 * i - 2], _tree[2 * i - 1]);
+            }
+        }
+
+        /** @brief Get the size of the underlying array */
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        /**
+         * @brief Get the value at the specified index of the underlying array.
+         *
+         * @param index The index to get the value from (0-based)
+         * @note Time complexity `O(1)`
+         */
+        T get(const std::size_t &index) const
+        {
+            return _tree[_size + index];
+        }
+
+        /**
+         * @brief Get the maximum element of the underlying array, or the lowest value of `T` if it is
+         * empty.
+         *
+         * @note Time complexity `O(1)`
+         */
+        T max() const
+        {
+            return _tree[1];
+        }
+
+        /**
+         * @brief Update a specific element of the underlying array
+         *
+         * @param index The index to update (0-based)
+         * @param value The new value
+         * @note Time complexity `O(logn)`, where `n` is the size of the underlying array.
+         */
+        void set(const std::size_t &index, const T &value)
+        {
+            std::size_t i = _size + index;
+            _tree[i] = value;
+            for (i /= 2; i > 0; i /= 2)
+            {
+                _tree[i] = std::max(_tree[2 * i], _tree[2 * i + 1]);
+            }
+        }
+    };
+}
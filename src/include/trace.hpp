@@ -0,0 +1,190 @@
+#pragma once
+
+#include "writer.hpp"
+
+namespace utils
+{
+    /**
+     * @brief A fixed-capacity single-producer single-consumer queue.
+     *
+     * Neither side ever blocks: `push` fails when the buffer is full and `drain` only takes the
+     * elements published so far.
+     */
+    template <typename T>
+    class RingBuffer
+    {
+    private:
+        std::vector<T> _buffer;
+        const std::size_t _mask;
+
+        /** @brief Number of elements ever pushed, written by the producer only */
+        std::atomic<std::size_t> _head;
+
+        /** @brief Number of elements ever drained, written by the consumer only */
+        std::atomic<std::size_t> _tail;
+
+    public:
+        /** @param capacity The number of elements, rounded up to a power of 2 */
+        RingBuffer(const std::size_t &capacity)
+            : _buffer(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+              _mask(_buffer.size() - 1),
+              _head(0),
+              _tail(0) {}
+
+        /** @brief Append an element, returning `false` (and dropping it) if the buffer is full. */
+        bool push(const T &value)
+        {
+            auto head = _head.load(std::memory_order_relaxed);
+            if (head - _tail.load(std::memory_order_acquire) == _buffer.size())
+            {
+                return false;
+            }
+
+            _buffer[head & _mask] = value;
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** @brief Call `function` on every element pushed so far, in order, and remove them. */
+        template <typename _Function>
+        void drain(_Function &&function)
+        {
+            auto tail = _tail.load(std::memory_order_relaxed), head = _head.load(std::memory_order_acquire);
+            for (auto i = tail; i < head; i++)
+            {
+                function(_buffer[i & _mask]);
+            }
+
+            _tail.store(head, std::memory_order_release);
+        }
+    };
+
+    /** @brief A single iteration of a search. */
+    struct TraceRecord
+    {
+        /** @brief Seconds since the start of the search */
+        double time;
+        std::size_t iteration;
+        double current_cost;
+        double best_cost;
+
+        /** @brief Index of the neighborhood explored */
+        std::size_t neighborhood;
+
+        /** @brief The tabu pair of the move performed, i.e. the customers it involves */
+        std::size_t first, second;
+    };
+
+    /**
+     * @brief Records the progress of a search to a CSV file without stalling it.
+     *
+     * The search pushes records into a ring buffer, from which a background thread periodically
+     * writes them out. If the writer falls behind and the buffer fills up, records are dropped
+     * rather than blocking the search; the number of dropped records is reported on destruction.
+     */
+    class ConvergenceTrace
+    {
+    private:
+        RingBuffer<TraceRecord> _records;
+        std::vector<std::string> _labels;
+        std::FILE *const _file;
+        std::size_t _dropped = 0;
+
+        std::atomic<bool> _stop;
+        std::thread _writer;
+
+        void _flush(BufferedWriter &writer);
+        void _write();
+
+    public:
+        /**
+         * @param path The CSV file to write
+         * @param capacity The number of records buffered before dropping
+         */
+        ConvergenceTrace(const std::string &path, const std::size_t &capacity = 1 << 16);
+
+        ConvergenceTrace(const ConvergenceTrace &) = delete;
+        ConvergenceTrace &operator=(const ConvergenceTrace &) = delete;
+
+        /** @brief Flush the remaining records and close the file. */
+        ~ConvergenceTrace();
+
+        /**
+         * @brief Set the names written for neighborhood indices. Must be called before the first
+         * `record`.
+         */
+        void set_labels(const std::vector<std::string> &labels)
+        {
+            _labels = labels;
+        }
+
+        /** @brief Record an iteration, never blocking. */
+        void record(const TraceRecord &record)
+        {
+            if (!_records.push(record))
+            {
+                _dropped++;
+            }
+        }
+    };
+
+    inline ConvergenceTrace::ConvergenceTrace(const std::string &path, const std::size_t &capacity)
+        : _records(capacity),
+          _file(std::fopen(path.c_str(), "w")),
+          _stop(false)
+    {
+        if (_file == nullptr)
+        {
+            throw std::runtime_error(format("Unable to open trace file \"%s\"", path.c_str()));
+        }
+
+        _writer = std::thread(&ConvergenceTrace::_write, this);
+    }
+
+    inline ConvergenceTrace::~ConvergenceTrace()
+    {
+        _stop = true;
+        _writer.join();
+        std::fclose(_file);
+
+        if (_dropped > 0)
+        {
+            std::cerr << format("Convergence trace: dropped %lu records", _dropped) << std::endl;
+        }
+    }
+
+    inline void ConvergenceTrace::_flush(BufferedWriter &writer)
+    {
+        _records.drain(
+            [this, &writer](const TraceRecord &record)
+            {
+                writer.write_number(record.time).put(',');
+                writer.write_number(record.iteration).put(',');
+                writer.write_number(record.current_cost).put(',');
+                writer.write_number(record.best_cost).put(',');
+                if (record.neighborhood < _labels.size())
+                {
+                    writer.put('"').write(_labels[record.neighborhood]).put('"');
+                }
+                else
+                {
+                    writer.write_number(record.neighborhood);
+                }
+
+                writer.put(',').write_number(record.first).put(',').write_number(record.second).put('\n');
+            });
+    }
+
+    inline void ConvergenceTrace::_write()
+    {
+        BufferedWriter writer(_file);
+        writer.write("time,iteration,current_cost,best_cost,neighborhood,first,second\n");
+        while (!_stop)
+        {
+            _flush(writer);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        _flush(writer);
+    }
+}
@@ -76,13 +76,13 @@ namespace utils
     }
 
     template <>
-    bool approximate(const double &first, const double &second)
+    inline bool approximate(const double &first, const double &second)
     {
         return abs(first - second) < 1.0e-6;
     }
 
     template <>
-    bool approximate(const float &first, const float &second)
+    inline bool approximate(const float &first, const float &second)
     {
         return abs(first - second) < 1.0e-6;
     }
@@ -99,19 +99,47 @@ namespace utils
             });
     }
 
+    template <typename _Tuple, typename _Function, std::size_t... _Indices>
+    void _visit_at(_Tuple &tuple, const std::size_t &index, _Function &&function, std::index_sequence<_Indices...>)
+    {
+        ((index == _Indices ? static_cast<void>(function(std::get<_Indices>(tuple))) : static_cast<void>(0)), ...);
+    }
+
+    /**
+     * @brief Invoke a function on the element at a runtime index of a tuple.
+     *
+     * Each branch is a direct call on a concrete element type, hence the function body can be
+     * inlined at every call site instead of going through virtual dispatch.
+     *
+     * @param tuple The tuple to visit
+     * @param index The index of the element (0-based)
+     * @param function The function to invoke, must accept every element type of the tuple
+     */
+    template <typename _Tuple, typename _Function>
+    void visit_at(_Tuple &tuple, const std::size_t &index, _Function &&function)
+    {
+        if (index >= std::tuple_size_v<_Tuple>)
+        {
+            throw std::out_of_range(format("Index %lu is out of range for a tuple of size %lu", index, std::tuple_size_v<_Tuple>));
+        }
+
+        _visit_at(tuple, index, std::forward<_Function>(function), std::make_index_sequence<std::tuple_size_v<_Tuple>>());
+    }
+
     /**
      * @brief Get the size of the console window using
      * [`GetConsoleScreenBufferInfo`](https://learn.microsoft.com/en-us/windows/console/getconsolescreenbufferinfo)
-     * or [`ioctl`](https://man7.org/linux/man-pages/man2/ioctl.2.html).
+     * or [`ioctl`](https://man7.org/linux/man-pages/man2/ioctl.2.html) on the standard error stream,
+     * where progress is drawn.
      *
      * @note In case it is not possible to get the console size, `std::runtime_error` is thrown.
      * @return The number of columns and rows, respectively.
      */
-    std::pair<unsigned short, unsigned short> get_console_size()
+    inline std::pair<unsigned short, unsigned short> get_console_size()
     {
 #if defined(WIN32)
         CONSOLE_SCREEN_BUFFER_INFO info;
-        if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+        if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_ERROR_HANDLE), &info))
         {
             throw std::runtime_error("GetConsoleScreenBufferInfo ERROR");
         }
@@ -123,7 +151,7 @@ namespace utils
 
 #elif defined(__linux__)
         struct winsize w;
-        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == -1)
+        if (ioctl(STDERR_FILENO, TIOCGWINSZ, &w) == -1)
         {
             throw std::runtime_error("ioctl ERROR");
         }
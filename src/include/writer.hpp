@@ -0,0 +1,124 @@
+#pragma once
+
+#include "standard.hpp"
+
+namespace utils
+{
+    /**
+     * @brief An output buffer formatting numbers with `std::to_chars` and flushing to a C stream in
+     * large blocks, bypassing iostream formatting.
+     *
+     * Without a stream, the writer only accumulates its output, which can then be retrieved with
+     * `buffer()`.
+     */
+    class BufferedWriter
+    {
+    private:
+        std::FILE *const _file;
+        const std::size_t _capacity;
+        std::string _buffer;
+
+        void _reserve(const std::size_t &size)
+        {
+            if (_file != nullptr && _buffer.size() + size > _capacity)
+            {
+                flush();
+            }
+        }
+
+    public:
+        /**
+         * @param file The stream to flush to, or `nullptr` to keep everything in memory
+         * @param capacity The buffer size at which the output is flushed to `file`
+         */
+        BufferedWriter(std::FILE *file = nullptr, const std::size_t &capacity = 1 << 16)
+            : _file(file), _capacity(capacity)
+        {
+            _buffer.reserve(_file == nullptr ? 256 : capacity);
+        }
+
+        BufferedWriter(const BufferedWriter &) = delete;
+        BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+        ~BufferedWriter()
+        {
+            flush();
+        }
+
+        BufferedWriter &put(const char &c)
+        {
+            _reserve(1);
+            _buffer.push_back(c);
+            return *this;
+        }
+
+        BufferedWriter &write(const std::string_view &text)
+        {
+            _reserve(text.size());
+            _buffer.append(text);
+            return *this;
+        }
+
+        /** @brief Write the shortest representation of a number, or `null` if it is not finite. */
+        template <typename T>
+        BufferedWriter &write_number(const T &value)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                if (!std::isfinite(value))
+                {
+                    return write("null");
+                }
+            }
+
+            char buffer[32];
+            auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            return write(std::string_view(buffer, ptr - buffer));
+        }
+
+        BufferedWriter &write_bool(const bool &value)
+        {
+            return write(value ? "true" : "false");
+        }
+
+        /** @brief Write a quoted and escaped JSON string. */
+        BufferedWriter &write_string(const std::string_view &value)
+        {
+            put('"');
+            for (auto &c : value)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    put('\\').put(c);
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    static const char digits[] = "0123456789abcdef";
+                    write("\\u00").put(digits[c >> 4]).put(digits[c & 0xf]);
+                }
+                else
+                {
+                    put(c);
+                }
+            }
+
+            return put('"');
+        }
+
+        /** @brief The pending output (all output if there is no stream). */
+        const std::string &buffer() const
+        {
+            return _buffer;
+        }
+
+        void flush()
+        {
+            if (_file != nullptr && !_buffer.empty())
+            {
+                std::fwrite(_buffer.data(), 1, _buffer.size(), _file);
+                std::fflush(_file);
+                _buffer.clear();
+            }
+        }
+    };
+}
@@ -1,11 +1,141 @@
-#include <solutions.hpp>
+#include <batch.hpp>
 
-int main()
+int main(int argc, char **argv)
 {
-    auto ptr = d2d::Solution::tabu_search();
-    std::cout << ptr->truck_routes << std::endl;
-    std::cout << ptr->drone_routes << std::endl;
-    std::cout << ptr->cost() << std::endl;
+    std::vector<std::string> args(argv + 1, argv + argc);
+    try
+    {
+        if (!args.empty() && (args.front() == "-h" || args.front() == "--help"))
+        {
+            std::cout << d2d::ProblemOptions::usage();
+            return 0;
+        }
+
+        if (!args.empty() && args.front() == "--batch")
+        {
+            if (args.size() < 2)
+            {
+                throw std::invalid_argument("Missing batch manifest path");
+            }
+
+            std::size_t threads = 0;
+            std::string output_path;
+            auto check_level = utils::CheckLevel::full;
+            std::size_t check_period = 100;
+            for (std::size_t i = 2; i < args.size(); i += 2)
+            {
+                if (i + 1 >= args.size())
+                {
+                    throw std::invalid_argument(utils::format("Missing value for argument %s", args[i].c_str()));
+                }
+
+                if (args[i] == "--threads")
+                {
+                    threads = d2d::_parse_number<std::size_t>(args[i + 1]);
+                }
+                else if (args[i] == "--output")
+                {
+                    output_path = args[i + 1];
+                }
+                else if (args[i] == "--checks")
+                {
+                    check_level = utils::DebugChecks::parse_level(args[i + 1]);
+                }
+                else if (args[i] == "--check-period")
+                {
+                    check_period = d2d::_parse_number<std::size_t>(args[i + 1]);
+                }
+                else
+                {
+                    throw std::invalid_argument(utils::format("Unrecognized argument %s", args[i].c_str()));
+                }
+            }
+
+            utils::debug_checks.configure(check_level, check_period);
+
+            std::ofstream output_file;
+            if (!output_path.empty())
+            {
+                output_file.open(output_path);
+                if (!output_file.is_open())
+                {
+                    throw std::runtime_error(utils::format("Unable to open batch output \"%s\"", output_path.c_str()));
+                }
+            }
+
+            d2d::BatchRunner runner(d2d::BatchJob::read_manifest(args[1]), threads, output_path.empty() ? std::cout : output_file);
+            return runner.run() == 0 ? 0 : 1;
+        }
+
+        if (args.empty())
+        {
+            // Legacy mode: the problem is piped from scripts/transform.py
+            auto ptr = d2d::Solution::tabu_search();
+            std::cout << ptr->truck_routes << std::endl;
+            std::cout << ptr->drone_routes << std::endl;
+            std::cout << ptr->cost() << std::endl;
+            return 0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto options = d2d::ProblemOptions::parse(args);
+        utils::debug_checks.configure(utils::DebugChecks::parse_level(options.checks), options.check_period);
+
+        if (options.seed.has_value())
+        {
+            utils::rng.seed(options.seed.value());
+        }
+
+        utils::PhaseTimings timings;
+        std::vector<std::pair<double, double>> history;
+        auto problem = d2d::load_problem(options, &timings);
+
+        std::unique_ptr<utils::ConvergenceTrace> trace;
+        if (!options.trace.empty())
+        {
+            trace = std::make_unique<utils::ConvergenceTrace>(options.trace);
+        }
+
+        std::unique_ptr<utils::ProgressReporter> progress;
+        if (options.verbose)
+        {
+            progress = std::make_unique<utils::ProgressReporter>(utils::ProgressReporter::parse_format(options.progress), options.iterations);
+        }
+
+        auto ptr = d2d::Solution::tabu_search(problem.get(), &timings, &history, trace.get(), progress.get());
+        progress.reset(); // Print the final state before the solution
+
+        if (options.format == "json")
+        {
+            utils::BufferedWriter writer(stdout);
+            d2d::write_solution_record(
+                writer,
+                options.instance_name(),
+                options,
+                *ptr,
+                timings,
+                history,
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            writer.put('\n');
+        }
+        else
+        {
+            std::cout << ptr->truck_routes << std::endl;
+            std::cout << ptr->drone_routes << std::endl;
+            std::cout << ptr->cost() << std::endl;
+        }
+    }
+    catch (std::invalid_argument &e)
+    {
+        std::cerr << e.what() << std::endl
+                  << d2d::ProblemOptions::usage();
+        return 2;
+    }
+    catch (std::runtime_error &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 
     return 0;
 }